@@ -221,7 +221,7 @@ static void removeACLEntry(sai_object_id_t aclSai) {
 
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
 
     if (retcode) {
         std::cout << "sai_api_query fail: " << esalSaiError(retcode) << "\n";
@@ -275,7 +275,7 @@ int VendorSetIngressVlanTranslation(uint16_t lPort,
 #ifndef UTS
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail " \
@@ -543,7 +543,7 @@ int VendorSetEgressVlanTranslation(uint16_t lPort,
 #ifndef UTS
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -766,7 +766,7 @@ bool esalCreateBpduTrapAcl() {
 #ifndef UTS
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -922,7 +922,7 @@ bool esalEnableBpduTrapOnPort(std::vector<sai_object_id_t>& portSaiList) {
 #ifndef UTS
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -1183,7 +1183,7 @@ bool esalCreateAclTable(aclTableAttributes aclTableAttr, sai_object_id_t& aclTab
     //
     sai_status_t retcode;
     sai_acl_api_t *saiAclApi;
-    retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail " \
@@ -1211,7 +1211,7 @@ bool esalRemoveAclTable(sai_object_id_t aclTableId) {
     //
 #ifndef UTS
     sai_acl_api_t *saiAclApi;
-    auto retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail " \
@@ -1241,7 +1241,7 @@ bool esalCreateAclCounter(aclCounterAttributes aclCounterAttr, sai_object_id_t&
     //
 #ifndef UTS
     sai_acl_api_t *saiAclApi;
-    auto retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -1293,7 +1293,7 @@ bool esalRemoveAclCounter(sai_object_id_t aclCounterId) {
     //
 #ifndef UTS
     sai_acl_api_t *saiAclApi;
-    auto retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -1328,7 +1328,7 @@ bool esalCreateAclEntry(aclEntryAttributes attrAcl, sai_object_id_t& aclEntryOid
     //
 #ifndef UTS
     sai_acl_api_t *saiAclApi;
-    auto retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -1588,7 +1588,7 @@ bool esalRemoveAclEntry(sai_object_id_t acl_entry_id) {
     //
 #ifndef UTS
     sai_acl_api_t *saiAclApi;
-    auto retcode =  sai_api_query(SAI_API_ACL, (void**) &saiAclApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_ACL, (void**) &saiAclApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                    SWERR_FILELINE,
@@ -125,7 +125,7 @@ bool esalBridgeCreate(void) {
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in esalBridgeCreate\n"));
@@ -183,7 +183,7 @@ bool esalBridgeRemove(void) {
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalBridgeRemove\n"));
@@ -241,7 +241,7 @@ bool esalBridgePortCreate(sai_object_id_t portSai,
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalBridgePortCreate\n"));
@@ -329,7 +329,7 @@ bool esalBridgePortRemove(sai_object_id_t portSai, uint16_t vlanId) {
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalBridgePortRemove\n"));
@@ -368,7 +368,7 @@ bool esalBridgePortListInit(uint32_t port_number)
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalBridgePortRemove\n"));
@@ -445,7 +445,7 @@ static int setMacLearning(uint16_t portId, bool enabled) {
     // Get the bridge API
     sai_status_t retcode;
     sai_bridge_api_t *saiBridgeApi;
-    retcode =  sai_api_query(SAI_API_BRIDGE, (void**) &saiBridgeApi);
+    retcode =  esalSaiApiQuery(SAI_API_BRIDGE, (void**) &saiBridgeApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in setMacLearning\n"));
@@ -486,6 +486,10 @@ static int setMacLearning(uint16_t portId, bool enabled) {
     return ESAL_RC_OK;
 }
 
+int esalBridgeSetMacLearning(uint16_t portId, bool enabled) {
+    return setMacLearning(portId, enabled);
+}
+
 int VendorDisableMacLearningPerPort(uint16_t lPort) {
     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort
               <<  " is NYI : FIXME " << std::endl;
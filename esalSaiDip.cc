@@ -108,4 +108,221 @@ EsalSaiDipEsalDumpSfp::dip_handle_cmd(const std::string & path,
 #endif
 }
 
+void
+EsalSaiDipEsalFdbBenchmark::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    uint32_t numEvents = 100000;
+    if (args.size() >= 2) {
+        numEvents = std::stoul(std::string(args[1]));
+    }
+    std::string report;
+    esalFdbBenchmark(numEvents, report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalFdbStats::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    uint64_t enqueued = 0, overflows = 0;
+    uint32_t depth = 0, highWater = 0;
+    esalFdbEventRingStats(&enqueued, &overflows, &depth, &highWater);
+    uint32_t fdbSize = 0, fdbCapacity = 0, fdbHighWater = 0;
+    uint64_t fdbDropped = 0;
+    bool fdbAlarm = false;
+    esalFdbTableStats(&fdbSize, &fdbCapacity, &fdbHighWater,
+                      &fdbDropped, &fdbAlarm);
+    std::stringstream ss;
+    ss << "fdbShadowSize         =  " << fdbSize << std::endl;
+    ss << "fdbShadowCapacity     =  " << fdbCapacity << std::endl;
+    ss << "fdbShadowOccupancyPct =  "
+       << (fdbCapacity ? (fdbSize * 100) / fdbCapacity : 0) << std::endl;
+    ss << "fdbShadowHighWater    =  " << fdbHighWater << std::endl;
+    ss << "fdbShadowDropped      =  " << fdbDropped << std::endl;
+    ss << "fdbShadowAlarm        =  " << (fdbAlarm ? "RAISED" : "clear") << std::endl;
+    uint64_t moves = 0, suppressedMac = 0, suppressedPort = 0;
+    uint32_t portsInStorm = 0;
+    esalFdbMoveStormStats(&moves, &suppressedMac, &suppressedPort,
+                          &portsInStorm);
+    ss << "fdbMoves              =  " << moves << std::endl;
+    ss << "fdbMovesSuppressedMac =  " << suppressedMac << std::endl;
+    ss << "fdbMovesSuppressedPort=  " << suppressedPort << std::endl;
+    ss << "fdbPortsInMoveStorm   =  " << portsInStorm << std::endl;
+    ss << "fdbEventRingDepth     =  " << depth << std::endl;
+    ss << "fdbEventEnqueued      =  " << enqueued << std::endl;
+    ss << "fdbEventOverflows     =  " << overflows << std::endl;
+    ss << "fdbEventHighWater     =  " << highWater << std::endl;
+    cmd_->dip_reply (ss.str().c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalFilterBenchmark::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    uint32_t numPackets = 100000;
+    if (args.size() >= 2) {
+        numPackets = std::stoul(std::string(args[1]));
+    }
+    std::string report;
+    esalFilterMatchBenchmark(numPackets, report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalRxQueueStats::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    std::string report;
+    esalHostRxQueueStats(report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalRxPolicerStats::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    if (args.size() >= 3) {
+        uint32_t pps = std::stoul(std::string(args[2]));
+        esalHostRxFilterPolicerConfig(std::string(args[1]), pps);
+    }
+    std::string report;
+    esalHostRxPolicerStats(report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalTxBenchmark::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    if (args.size() < 2) {
+        cmd_->dip_reply("esalTxBenchmark lPort [numPkts]");
+    } else {
+        uint16_t lPort = std::stoi(std::string(args[1]));
+        uint32_t numPkts = 10000;
+        if (args.size() >= 3) {
+            numPkts = std::stoul(std::string(args[2]));
+        }
+        std::string report;
+        esalTxBenchmark(lPort, numPkts, report);
+        cmd_->dip_reply(report.c_str());
+    }
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalCapture::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    std::string usage = "esalCapture on [slots] [snapLen] [path] | off | "
+                        "filter [rx|tx] [port=N] [filter=name] "
+                        "[offset:data[:mask]]... | status";
+    std::string report;
+    if (args.size() < 2) {
+        cmd_->dip_reply(usage.c_str());
+    } else if (args[1] == "on") {
+        uint32_t slots = 0;
+        uint32_t snapLen = 0;
+        std::string file;
+        if (args.size() >= 3) {
+            slots = std::stoul(std::string(args[2]));
+        }
+        if (args.size() >= 4) {
+            snapLen = std::stoul(std::string(args[3]));
+        }
+        if (args.size() >= 5) {
+            file = args[4];
+        }
+        if (!esalHostCaptureStart(slots, snapLen, file)) {
+            cmd_->dip_reply("esalCapture failed to start");
+        }
+        esalHostCaptureStats(report);
+        cmd_->dip_reply(report.c_str());
+    } else if (args[1] == "off") {
+        esalHostCaptureStats(report);
+        esalHostCaptureStop();
+        cmd_->dip_reply(report.c_str());
+    } else if (args[1] == "filter") {
+        std::string spec;
+        for (size_t i = 2; i < args.size(); i++) {
+            spec += args[i] + " ";
+        }
+        if (!esalHostCaptureFilter(spec)) {
+            cmd_->dip_reply("esalCapture bad filter");
+        }
+    } else if (args[1] == "status") {
+        esalHostCaptureStats(report);
+        cmd_->dip_reply(report.c_str());
+    } else {
+        cmd_->dip_reply(usage.c_str());
+    }
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalRxStats::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    std::string report;
+    esalHostRxStats(report);
+    cmd_->dip_reply(report.c_str());
+    if ((args.size() >= 2) && (args[1] == "clear")) {
+        esalHostRxStatsClear();
+    }
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalPortState::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    int32_t lPort = -1;
+    bool refresh = false;
+    if ((args.size() >= 2) && (args[1] != "all")) {
+        lPort = std::stoi(std::string(args[1]));
+    }
+    if ((args.size() >= 3) && (args[2] == "refresh")) {
+        refresh = true;
+    }
+    std::string report;
+    esalPortStateDump(lPort, refresh, report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
+void
+EsalSaiDipEsalLinkEvents::dip_handle_cmd(const std::string & path,
+				       const std::vector < std::string >
+				       &args) {
+#ifndef UTS
+    std::string report;
+    esalLinkEventDump((args.size() >= 2) && (args[1] == "clear"), report);
+    cmd_->dip_reply(report.c_str());
+    cmd_->dip_reply (DIP_CMD_HANDLED);
+#endif
+}
+
 #endif
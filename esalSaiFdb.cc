@@ -17,6 +17,14 @@
 #include <mutex>
 #include <vector>
 #include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "sai/sai.h"
 #include "sai/saiport.h"
@@ -30,18 +38,660 @@
 
 // Updates to the table comes from a notification in SAI Switch which is a single 
 // thread.   All updates are done in the shadow.  We have multiple readers so
-// no need for mutex. At worst, an inconsistent record when some of the fields
-// in an entry are temporarily not for the same update.  There is no dereferenced
-// pointer so no risk of trap. 
+// the table is guarded by a sequence lock rather than a mutex.  The writer
+// makes the sequence odd while it changes the table and even again when done,
+// and never waits.  Readers copy what they need, then retry if the sequence
+// moved, so they never see a torn entry or a list being relinked.  There is
+// no dereferenced pointer so a racing reader has no risk of trap. 
 struct FdbEntry {
     sai_mac_t macAddr;
     uint16_t egressPort;
     sai_object_id_t vlanSai;
+    // Intrusive links for the per-port and per-vlan buckets, by table index.
+    int32_t portNext;
+    int32_t portPrev;
+    int32_t vlanNext;
+    int32_t vlanPrev;
 };
 
-const int MAX_FDB_TABLE_SIZE = 4096;
-static FdbEntry fdbTable[MAX_FDB_TABLE_SIZE]; 
-static int fdbTableSize = 0; 
+// The shadow is sized at init from the FDB capacity the device reports, so
+// it holds everything the ASIC can learn.  The default is only used when the
+// device can't be asked.  The absolute cap guards against a bad read.
+const uint32_t FDB_DEFAULT_TABLE_SIZE = 4096;
+const uint32_t FDB_MAX_TABLE_SIZE = 1024 * 1024;
+
+// Occupancy alarm raised at the high-water mark and cleared once the table
+// drains back below the low-water mark, so it doesn't chatter.
+const uint32_t FDB_ALARM_HIGH_PCT = 90;
+const uint32_t FDB_ALARM_LOW_PCT = 80;
+
+// The entries are kept dense so that readers can walk [0, size) as before.
+// The hash index maps (MAC, VLAN) onto a position in the dense table using
+// open addressing with linear probing.  It is at least twice the table size,
+// and a power of two, so probe chains stay short and the slot is a mask away.
+// Deletes use backward shift so there are no tombstones to clean up.
+const int32_t FDB_HASH_EMPTY = -1;
+
+// Secondary indexes so a port or vlan flush, and the per-port MAC dump, only
+// touch the entries of interest.  Buckets are chosen by masking the port id
+// or the vlan OID value; members of a bucket are still checked for a match.
+const int FDB_PORT_BUCKETS = 512;
+const int FDB_VLAN_BUCKETS = 4096;
+const int32_t FDB_LINK_NONE = -1;
+
+// The entries and the hash index are carved out of one arena allocated at
+// init, so the memory cost is fixed and known up front.
+struct FdbTable {
+    FdbEntry *entries;
+    int32_t *index;
+    int32_t portHead[FDB_PORT_BUCKETS];
+    int32_t vlanHead[FDB_VLAN_BUCKETS];
+    int size;
+    int capacity;
+    int slotMask;
+    std::atomic<uint32_t> seq;
+    uint8_t *arena;
+    size_t arenaBytes;
+    int highWater;
+    uint64_t dropped;
+    bool alarm;
+    // Set on the shadow only, scratch tables skip journaling and dampening.
+    bool live;
+};
+
+static FdbTable fdbShadow;
+static std::atomic<bool> fdbShadowInit(false);
+
+// Every change to the shadow is appended to a journal so pollers can ask
+// for what changed since a generation instead of copying whole tables.
+// The journal is a ring, records are overwritten oldest first, and a
+// poller that falls behind by more than the ring is told to resync.
+// Flushes are journaled as one record for the port, vlan or whole table.
+const uint32_t FDB_JOURNAL_SIZE = 16384;
+
+struct FdbJournalRec {
+    uint64_t gen;
+    uint8_t op;
+    sai_mac_t macAddr;
+    uint16_t egressPort;
+    sai_object_id_t vlanSai;
+};
+
+static FdbJournalRec fdbJournal[FDB_JOURNAL_SIZE];
+static std::atomic<uint64_t> fdbJournalGen(0);
+
+static void fdbJournalAppend(const FdbTable &tbl, uint8_t op,
+    const sai_mac_t mac, sai_object_id_t vlanSai, uint16_t portId) {
+    if (!tbl.live) {
+        return;
+    }
+
+    // Fill in the record, then publish the generation.
+    uint64_t gen = fdbJournalGen.load(std::memory_order_relaxed) + 1;
+    auto &rec = fdbJournal[gen & (FDB_JOURNAL_SIZE - 1)];
+    rec.op = op;
+    if (mac) {
+        memcpy(rec.macAddr, mac, sizeof(sai_mac_t));
+    } else {
+        memset(rec.macAddr, 0, sizeof(sai_mac_t));
+    }
+    rec.egressPort = portId;
+    rec.vlanSai = vlanSai;
+    rec.gen = gen;
+    fdbJournalGen.store(gen, std::memory_order_release);
+}
+
+// Spins a reader does before yielding to let the writer finish.
+const int FDB_READ_SPINS = 64;
+
+static inline void fdbWriteBegin(FdbTable &tbl) {
+    tbl.seq.store(tbl.seq.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+static inline void fdbWriteEnd(FdbTable &tbl) {
+    tbl.seq.store(tbl.seq.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_release);
+}
+
+// Returns an even sequence number to validate the read against.
+static inline uint32_t fdbReadBegin(const FdbTable &tbl) {
+    int spins = 0;
+    uint32_t seq;
+    while ((seq = tbl.seq.load(std::memory_order_acquire)) & 1) {
+        if (++spins >= FDB_READ_SPINS) {
+            std::this_thread::yield();
+            spins = 0;
+        }
+    }
+    return seq;
+}
+
+static inline bool fdbReadValid(const FdbTable &tbl, uint32_t seq) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return tbl.seq.load(std::memory_order_relaxed) == seq;
+}
+
+static inline uint64_t fdbPackMac(const sai_mac_t mac) {
+    return ((uint64_t) mac[0] << 40) | ((uint64_t) mac[1] << 32) |
+           ((uint64_t) mac[2] << 24) | ((uint64_t) mac[3] << 16) |
+           ((uint64_t) mac[4] << 8)  |  (uint64_t) mac[5];
+}
+
+static inline uint32_t fdbHashSlot(
+    uint64_t packedMac, sai_object_id_t vlanSai) {
+    // Pack the 48-bit MAC with the low bits of the VLAN OID value and run
+    // it through a 64-bit finalizer so sequential MACs spread out.
+    uint64_t key = (packedMac << 16) ^ GET_OID_VAL(vlanSai);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (uint32_t) key;
+}
+
+static inline int fdbHashMask(const FdbTable &tbl, uint64_t packedMac,
+                              sai_object_id_t vlanSai) {
+    return fdbHashSlot(packedMac, vlanSai) & tbl.slotMask;
+}
+
+static inline int fdbPortBucket(uint16_t portId) {
+    return portId & (FDB_PORT_BUCKETS - 1);
+}
+
+static inline int fdbVlanBucket(sai_object_id_t vlanSai) {
+    return (int) (GET_OID_VAL(vlanSai) & (FDB_VLAN_BUCKETS - 1));
+}
+
+static void fdbTableReset(FdbTable &tbl) {
+    tbl.size = 0;
+    for (auto i = 0; i <= tbl.slotMask; i++) {
+        tbl.index[i] = FDB_HASH_EMPTY;
+    }
+    for (auto i = 0; i < FDB_PORT_BUCKETS; i++) {
+        tbl.portHead[i] = FDB_LINK_NONE;
+    }
+    for (auto i = 0; i < FDB_VLAN_BUCKETS; i++) {
+        tbl.vlanHead[i] = FDB_LINK_NONE;
+    }
+}
+
+static bool fdbTableAlloc(FdbTable &tbl, uint32_t capacity) {
+    if (!capacity) capacity = FDB_DEFAULT_TABLE_SIZE;
+    if (capacity > FDB_MAX_TABLE_SIZE) capacity = FDB_MAX_TABLE_SIZE;
+    uint32_t slots = 1;
+    while (slots < 2 * capacity) slots <<= 1;
+
+    size_t entryBytes = capacity * sizeof(FdbEntry);
+    size_t indexBytes = slots * sizeof(int32_t);
+    uint8_t *arena = new (std::nothrow) uint8_t[entryBytes + indexBytes];
+    if (!arena) {
+        return false;
+    }
+
+    tbl.arena = arena;
+    tbl.arenaBytes = entryBytes + indexBytes;
+    tbl.entries = reinterpret_cast<FdbEntry*>(arena);
+    tbl.index = reinterpret_cast<int32_t*>(arena + entryBytes);
+    tbl.capacity = capacity;
+    tbl.slotMask = slots - 1;
+    tbl.highWater = 0;
+    tbl.dropped = 0;
+    tbl.alarm = false;
+    tbl.live = false;
+    fdbTableReset(tbl);
+    return true;
+}
+
+static void fdbTableFree(FdbTable &tbl) {
+    delete [] tbl.arena;
+    tbl.arena = 0;
+    tbl.arenaBytes = 0;
+    tbl.entries = 0;
+    tbl.index = 0;
+    tbl.capacity = 0;
+    tbl.size = 0;
+}
+
+static void fdbLinkPort(FdbTable &tbl, int pos) {
+    auto &fdb = tbl.entries[pos];
+    int32_t &head = tbl.portHead[fdbPortBucket(fdb.egressPort)];
+    fdb.portPrev = FDB_LINK_NONE;
+    fdb.portNext = head;
+    if (head != FDB_LINK_NONE) {
+        tbl.entries[head].portPrev = pos;
+    }
+    head = pos;
+}
+
+static void fdbUnlinkPort(FdbTable &tbl, int pos) {
+    auto &fdb = tbl.entries[pos];
+    if (fdb.portPrev != FDB_LINK_NONE) {
+        tbl.entries[fdb.portPrev].portNext = fdb.portNext;
+    } else {
+        tbl.portHead[fdbPortBucket(fdb.egressPort)] = fdb.portNext;
+    }
+    if (fdb.portNext != FDB_LINK_NONE) {
+        tbl.entries[fdb.portNext].portPrev = fdb.portPrev;
+    }
+}
+
+static void fdbLinkVlan(FdbTable &tbl, int pos) {
+    auto &fdb = tbl.entries[pos];
+    int32_t &head = tbl.vlanHead[fdbVlanBucket(fdb.vlanSai)];
+    fdb.vlanPrev = FDB_LINK_NONE;
+    fdb.vlanNext = head;
+    if (head != FDB_LINK_NONE) {
+        tbl.entries[head].vlanPrev = pos;
+    }
+    head = pos;
+}
+
+static void fdbUnlinkVlan(FdbTable &tbl, int pos) {
+    auto &fdb = tbl.entries[pos];
+    if (fdb.vlanPrev != FDB_LINK_NONE) {
+        tbl.entries[fdb.vlanPrev].vlanNext = fdb.vlanNext;
+    } else {
+        tbl.vlanHead[fdbVlanBucket(fdb.vlanSai)] = fdb.vlanNext;
+    }
+    if (fdb.vlanNext != FDB_LINK_NONE) {
+        tbl.entries[fdb.vlanNext].vlanPrev = fdb.vlanPrev;
+    }
+}
+
+// Returns the hash slot holding the (MAC, VLAN) pair, or the empty slot where
+// it would be inserted.  The index is never full, so the probe terminates.
+static int fdbTableProbe(
+    const FdbTable &tbl, const sai_mac_t mac, sai_object_id_t vlanSai) {
+    uint64_t packedMac = fdbPackMac(mac);
+    int slot = fdbHashMask(tbl, packedMac, vlanSai);
+    while (tbl.index[slot] != FDB_HASH_EMPTY) {
+        auto &fdb = tbl.entries[tbl.index[slot]];
+        if ((fdb.vlanSai == vlanSai) && (fdbPackMac(fdb.macAddr) == packedMac)) {
+            break;
+        }
+        slot = (slot + 1) & tbl.slotMask;
+    }
+    return slot;
+}
+
+// MAC move storm dampening, off unless provisioned.  During an L2 loop the
+// same MACs bounce between ports thousands of times a second.  Per-MAC move
+// rates are estimated with a count-min sketch reset every window, and
+// per-port moves are metered by a token bucket.  Every move still updates
+// the shadow and is journaled, so delta pollers never lose a move; moves
+// over either limit are counted as dampened.  A MAC over its limit raises
+// the flapping alarm.  A port that runs out of tokens raises an alarm and,
+// if provisioned, has learning disabled until the hold-down expires, which
+// is what actually quiets the loop.  Alarms and learning changes are
+// queued and carried out by fdbMoveStormActions once the write section is
+// closed, so readers never wait on I/O or SAI.
+const int FDB_MOVE_SKETCH_ROWS = 4;
+const int FDB_MOVE_SKETCH_WIDTH = 2048;
+const uint64_t FDB_MOVE_WINDOW_MSEC = 1000;
+
+struct FdbMoveStorm {
+    uint32_t macThreshold = 0;
+    uint32_t portThreshold = 0;
+    uint32_t holdMsec = 30000;
+    bool disableLearning = false;
+    uint64_t windowStart = 0;
+    uint16_t sketch[FDB_MOVE_SKETCH_ROWS][FDB_MOVE_SKETCH_WIDTH] = {};
+    bool macAlarm = false;
+    uint32_t tokens[FDB_PORT_BUCKETS] = {};
+    uint64_t lastRefill[FDB_PORT_BUCKETS] = {};
+    uint64_t stormStart[FDB_PORT_BUCKETS] = {};
+    bool inStorm[FDB_PORT_BUCKETS] = {};
+    bool learningOff[FDB_PORT_BUCKETS] = {};
+    uint32_t portsInStorm = 0;
+    uint64_t moves = 0;
+    uint64_t suppressedMac = 0;
+    uint64_t suppressedPort = 0;
+
+    // Deferred to fdbMoveStormActions.
+    bool actionsPending = false;
+    bool raisePending[FDB_PORT_BUCKETS] = {};
+    bool clearPending[FDB_PORT_BUCKETS] = {};
+    bool macAlarmPending = false;
+    sai_mac_t macAlarmMac = {};
+    uint16_t macAlarmPort = 0;
+};
+
+static FdbMoveStorm fdbMoveStorm;
+
+static inline uint64_t fdbNowMsec(void) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void fdbMoveStormRaise(uint16_t portId, uint64_t now) {
+    auto &ms = fdbMoveStorm;
+    ms.inStorm[portId] = true;
+    ms.stormStart[portId] = now;
+    ms.portsInStorm++;
+    ms.raisePending[portId] = true;
+    ms.actionsPending = true;
+}
+
+// Clears port storms whose hold-down has expired.  Writer thread only.
+static void fdbMoveStormRecover(uint64_t now) {
+    auto &ms = fdbMoveStorm;
+    if (!ms.portsInStorm) {
+        return;
+    }
+    for (auto portId = 0; portId < FDB_PORT_BUCKETS; portId++) {
+        if (!ms.inStorm[portId] || ((now - ms.stormStart[portId]) < ms.holdMsec)) {
+            continue;
+        }
+        ms.inStorm[portId] = false;
+        ms.tokens[portId] = ms.portThreshold;
+        ms.lastRefill[portId] = now;
+        ms.portsInStorm--;
+        ms.clearPending[portId] = true;
+        ms.actionsPending = true;
+    }
+}
+
+// Reports and applies what the move storm code queued.  Writer thread
+// only, outside any write section.
+static void fdbMoveStormActions(void) {
+    auto &ms = fdbMoveStorm;
+    if (!ms.actionsPending) {
+        return;
+    }
+    ms.actionsPending = false;
+
+    if (ms.macAlarmPending) {
+        ms.macAlarmPending = false;
+        const uint8_t *mac = ms.macAlarmMac;
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "FDB MAC flapping\n"));
+        std::cout << "FDB MAC flapping: " << std::hex
+                  << (int) mac[0] << ":" << (int) mac[1] << ":"
+                  << (int) mac[2] << ":" << (int) mac[3] << ":"
+                  << (int) mac[4] << ":" << (int) mac[5] << std::dec
+                  << " port: " << ms.macAlarmPort << "\n" << std::flush;
+    }
+
+    for (auto portId = 0; portId < FDB_PORT_BUCKETS; portId++) {
+        if (ms.raisePending[portId]) {
+            ms.raisePending[portId] = false;
+            SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                SWERR_FILELINE, "FDB MAC move storm\n"));
+            std::cout << "FDB MAC move storm on port: " << portId
+                      << "\n" << std::flush;
+            if (ms.disableLearning && !ms.learningOff[portId] &&
+                (esalBridgeSetMacLearning(portId, false) == ESAL_RC_OK)) {
+                ms.learningOff[portId] = true;
+            }
+        }
+        if (ms.clearPending[portId]) {
+            ms.clearPending[portId] = false;
+            if (ms.learningOff[portId]) {
+                esalBridgeSetMacLearning(portId, true);
+                ms.learningOff[portId] = false;
+            }
+            std::cout << "FDB MAC move storm cleared on port: " << portId
+                      << "\n" << std::flush;
+        }
+    }
+}
+
+// Meters a move against the per-MAC and per-port limits.  Writer thread only.
+static void fdbMoveMeter(const sai_mac_t mac, sai_object_id_t vlanSai,
+                         uint16_t portId) {
+    auto &ms = fdbMoveStorm;
+    uint64_t now = fdbNowMsec();
+    ms.moves++;
+
+    if ((now - ms.windowStart) >= FDB_MOVE_WINDOW_MSEC) {
+        memset(ms.sketch, 0, sizeof(ms.sketch));
+        ms.windowStart = now;
+        ms.macAlarm = false;
+    }
+
+    // Count-min estimate of this MAC's moves in the window.
+    uint32_t hash = fdbHashSlot(fdbPackMac(mac), vlanSai);
+    uint32_t h1 = hash & 0xFFFF;
+    uint32_t h2 = (hash >> 16) | 1;
+    uint32_t estimate = UINT32_MAX;
+    for (auto row = 0; row < FDB_MOVE_SKETCH_ROWS; row++) {
+        uint16_t &cnt = ms.sketch[row][(h1 + row * h2) & (FDB_MOVE_SKETCH_WIDTH - 1)];
+        if (cnt < UINT16_MAX) cnt++;
+        if (cnt < estimate) estimate = cnt;
+    }
+    if (ms.macThreshold && (estimate > ms.macThreshold)) {
+        ms.suppressedMac++;
+        if (!ms.macAlarm) {
+            ms.macAlarm = true;
+            memcpy(ms.macAlarmMac, mac, sizeof(sai_mac_t));
+            ms.macAlarmPort = portId;
+            ms.macAlarmPending = true;
+            ms.actionsPending = true;
+        }
+        return;
+    }
+
+    // Token bucket on the port being moved to.
+    if (!ms.portThreshold || (portId >= FDB_PORT_BUCKETS)) {
+        return;
+    }
+    fdbMoveStormRecover(now);
+    if (ms.inStorm[portId]) {
+        ms.suppressedPort++;
+        return;
+    }
+    uint64_t refill = ((now - ms.lastRefill[portId]) * ms.portThreshold) / 1000;
+    if (refill) {
+        uint64_t tokens = ms.tokens[portId] + refill;
+        ms.tokens[portId] = (tokens > ms.portThreshold) ? ms.portThreshold : tokens;
+        ms.lastRefill[portId] = now;
+    }
+    if (!ms.tokens[portId]) {
+        ms.suppressedPort++;
+        fdbMoveStormRaise(portId, now);
+        return;
+    }
+    ms.tokens[portId]--;
+}
+
+static void fdbTableSetPort(FdbTable &tbl, int pos, uint16_t portId) {
+    auto &fdb = tbl.entries[pos];
+    if (fdb.egressPort == portId) {
+        return;
+    }
+    // Hardware has already moved the MAC, so the shadow and the journal
+    // always follow; dampening only meters the move.
+    if (tbl.live) {
+        fdbMoveMeter(fdb.macAddr, fdb.vlanSai, portId);
+    }
+    fdbUnlinkPort(tbl, pos);
+    fdb.egressPort = portId;
+    fdbLinkPort(tbl, pos);
+    fdbJournalAppend(tbl, MAC_DELTA_MOVE, fdb.macAddr, fdb.vlanSai, portId);
+}
+
+static bool fdbTableInsert(FdbTable &tbl,
+    const sai_mac_t mac, sai_object_id_t vlanSai, uint16_t portId) {
+    int slot = fdbTableProbe(tbl, mac, vlanSai);
+    if (tbl.index[slot] != FDB_HASH_EMPTY) {
+        // Already known, treat it as a station move.
+        fdbTableSetPort(tbl, tbl.index[slot], portId);
+        return true;
+    }
+    if (tbl.size >= tbl.capacity) {
+        tbl.dropped++;
+        return false;
+    }
+
+    // Fill in the shadow entry first, then publish by bumping the size.
+    int pos = tbl.size;
+    auto &newEntry = tbl.entries[pos];
+    memcpy(newEntry.macAddr, mac, sizeof(sai_mac_t));
+    newEntry.egressPort = portId;
+    newEntry.vlanSai = vlanSai;
+    fdbLinkPort(tbl, pos);
+    fdbLinkVlan(tbl, pos);
+    tbl.index[slot] = pos;
+    tbl.size++;
+    fdbJournalAppend(tbl, MAC_DELTA_LEARN, mac, vlanSai, portId);
+
+    if (tbl.size > tbl.highWater) {
+        tbl.highWater = tbl.size;
+    }
+    if (!tbl.alarm &&
+        ((uint64_t) tbl.size * 100 >= (uint64_t) tbl.capacity * FDB_ALARM_HIGH_PCT)) {
+        tbl.alarm = true;
+        if (&tbl == &fdbShadow) {
+            SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                SWERR_FILELINE, "FDB shadow occupancy high-water\n"));
+            std::cout << "FDB shadow occupancy high-water: " << tbl.size
+                      << "/" << tbl.capacity << "\n" << std::flush;
+        }
+    }
+    return true;
+}
+
+// Move the entry at "from" into the free position "to", repointing its hash
+// slot and its neighbours in both bucket lists.
+static void fdbTableRelocate(FdbTable &tbl, int from, int to) {
+    auto &fdb = tbl.entries[from];
+    int slot = fdbTableProbe(tbl, fdb.macAddr, fdb.vlanSai);
+    tbl.entries[to] = fdb;
+
+    auto &moved = tbl.entries[to];
+    if (moved.portPrev != FDB_LINK_NONE) {
+        tbl.entries[moved.portPrev].portNext = to;
+    } else {
+        tbl.portHead[fdbPortBucket(moved.egressPort)] = to;
+    }
+    if (moved.portNext != FDB_LINK_NONE) {
+        tbl.entries[moved.portNext].portPrev = to;
+    }
+    if (moved.vlanPrev != FDB_LINK_NONE) {
+        tbl.entries[moved.vlanPrev].vlanNext = to;
+    } else {
+        tbl.vlanHead[fdbVlanBucket(moved.vlanSai)] = to;
+    }
+    if (moved.vlanNext != FDB_LINK_NONE) {
+        tbl.entries[moved.vlanNext].vlanPrev = to;
+    }
+    tbl.index[slot] = to;
+}
+
+static void fdbTableRemoveSlot(FdbTable &tbl, int slot) {
+    int pos = tbl.index[slot];
+    int last = tbl.size - 1;
+
+    // Keep the entries dense by moving the last entry into the hole.
+    fdbUnlinkPort(tbl, pos);
+    fdbUnlinkVlan(tbl, pos);
+    if (pos != last) {
+        fdbTableRelocate(tbl, last, pos);
+    }
+    tbl.size--;
+
+    // Backward shift deletion, pull later members of the probe chain
+    // forward so lookups never need tombstones.
+    int hole = slot;
+    int next = (hole + 1) & tbl.slotMask;
+    while (tbl.index[next] != FDB_HASH_EMPTY) {
+        auto &fdb = tbl.entries[tbl.index[next]];
+        int home = fdbHashMask(tbl, fdbPackMac(fdb.macAddr), fdb.vlanSai);
+        if (((next - home) & tbl.slotMask) >= ((next - hole) & tbl.slotMask)) {
+            tbl.index[hole] = tbl.index[next];
+            hole = next;
+        }
+        next = (next + 1) & tbl.slotMask;
+    }
+    tbl.index[hole] = FDB_HASH_EMPTY;
+
+    if (tbl.alarm &&
+        ((uint64_t) tbl.size * 100 < (uint64_t) tbl.capacity * FDB_ALARM_LOW_PCT)) {
+        tbl.alarm = false;
+        if (&tbl == &fdbShadow) {
+            std::cout << "FDB shadow occupancy high-water cleared: " << tbl.size
+                      << "/" << tbl.capacity << "\n" << std::flush;
+        }
+    }
+}
+
+// Removes the entry at a table position and returns the position the
+// caller's saved "next" link now refers to, since the last entry may have
+// been moved into the hole.
+static int fdbTableRemovePos(FdbTable &tbl, int pos, int next) {
+    int last = tbl.size - 1;
+    auto &fdb = tbl.entries[pos];
+    fdbTableRemoveSlot(tbl, fdbTableProbe(tbl, fdb.macAddr, fdb.vlanSai));
+    return (next == last) ? pos : next;
+}
+
+static void fdbTableFlushPort(FdbTable &tbl, uint16_t portId) {
+    int pos = tbl.portHead[fdbPortBucket(portId)];
+    while (pos != FDB_LINK_NONE) {
+        int next = tbl.entries[pos].portNext;
+        if (tbl.entries[pos].egressPort == portId) {
+            next = fdbTableRemovePos(tbl, pos, next);
+        }
+        pos = next;
+    }
+}
+
+static void fdbTableFlushVlan(FdbTable &tbl, sai_object_id_t vlanSai) {
+    int pos = tbl.vlanHead[fdbVlanBucket(vlanSai)];
+    while (pos != FDB_LINK_NONE) {
+        int next = tbl.entries[pos].vlanNext;
+        if (tbl.entries[pos].vlanSai == vlanSai) {
+            next = fdbTableRemovePos(tbl, pos, next);
+        }
+        pos = next;
+    }
+}
+
+// FDB notifications are copied out of the SAI callback into a ring and
+// applied by the ESAL FDB worker, so slow table work or logging never stalls
+// the SAI event thread.  Warm restart replay runs on another thread but goes
+// through the same ring, so replayed and live events are applied in the
+// order they were queued; producers take turns under fdbProducerMutex, the
+// worker consumes without a lock.  The attribute list is copied since SAI
+// owns the memory.
+const int FDB_RING_MAX_ATTRS = 4;
+const uint32_t FDB_RING_DEFAULT_DEPTH = 4096;
+const uint32_t FDB_RING_MIN_DEPTH = 256;
+const uint32_t FDB_RING_MAX_DEPTH = 65536;
+const int FDB_EVENT_BATCH = 64;
+const int FDB_WORKER_IDLE_USEC = 1000;
+
+struct FdbRingEvent {
+    sai_fdb_event_t eventType;
+    sai_fdb_entry_t fdbEntry;
+    uint32_t attrCount;
+    sai_attribute_t attr[FDB_RING_MAX_ATTRS];
+};
+
+struct FdbEventRing {
+    std::vector<FdbRingEvent> events;
+    uint32_t mask;
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    alignas(64) std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> overflows;
+    std::atomic<uint32_t> highWater;
+};
+
+static FdbEventRing fdbEventRing;
+static std::atomic<bool> fdbWorkerRunning(false);
+static std::atomic<bool> fdbWorkerLeave(false);
+static pthread_t fdbWorkerTid;
+
+// Producers check fdbWorkerRunning and queue under this mutex, and apply
+// events inline under it once the worker is gone.  Stop holds it while it
+// joins the worker and drains the ring, so a late notification either
+// lands in the ring before the drain or is applied inline after it, and
+// there is only ever one writer on the shadow.
+static std::mutex fdbProducerMutex;
 
 extern "C" {
 
@@ -67,15 +717,13 @@ static bool findVlanSaiInAttr(
     return false; 
 }
 
-void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
-     // Verify pointer
-     if (!fdbNotify) return; 
-
+static void fdbApplyEventBody(
+    FdbTable &tbl, sai_fdb_event_notification_data_t *fdbNotify) {
      sai_fdb_entry_t &fdbUpd = fdbNotify->fdb_entry;
 
-     FdbEntry newEntry;
      uint16_t portId; 
      sai_object_id_t vlanSai;
+     int slot;
      
      // Action may be either LEARN, AGE, MOVE, or FLUSH.
      switch (fdbNotify->event_type) {
@@ -85,28 +733,7 @@ void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
                  fdbNotify->attr, &portId)){
                 return; 
              }
-             for(int i = 0; i < fdbTableSize; i++) {
-                 auto &fdb = fdbTable[i];
-                 if ((fdb.egressPort == portId) && 
-                     !memcmp(fdb.macAddr, fdbUpd.mac_address, sizeof(sai_mac_t))){
-                    return;
-                 }
-             }
-  
-             if (fdbTableSize < MAX_FDB_TABLE_SIZE) {
-                 memcpy(newEntry.macAddr, fdbUpd.mac_address, sizeof(sai_mac_t));
-                 newEntry.egressPort = portId; 
-                 newEntry.vlanSai = fdbUpd.bv_id;
-                 fdbTable[fdbTableSize++] = newEntry; 
-#ifdef LARCH_ENVIRON
-                 std::cout << "New Mac Learned: " << std::hex << newEntry.macAddr[0]
-                           << ":" << std::hex << newEntry.macAddr[1] << ":" << std::hex << newEntry.macAddr[2]
-                           << ":" << std::hex << newEntry.macAddr[3] << ":" << std::hex << newEntry.macAddr[4]
-                           << ":" << std::hex << newEntry.macAddr[5]
-                           << ", port = " << portId << ", vlan = " << fdbUpd.bv_id
-                           << "\n";
-#endif
-             }
+             fdbTableInsert(tbl, fdbUpd.mac_address, fdbUpd.bv_id, portId);
              break; 
 
          case SAI_FDB_EVENT_AGED:
@@ -115,14 +742,12 @@ void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
                      fdbNotify->attr, &portId)){
                 return; 
              }
-             for(int i = 0; i < fdbTableSize; i++) {
-                 auto &fdb = fdbTable[i];
-                 if ((fdb.egressPort == portId) && 
-                     !memcmp(fdb.macAddr, fdbUpd.mac_address, sizeof(sai_mac_t))){
-                    fdbTable[i] = fdbTable[fdbTableSize-1];
-                    fdbTableSize--;
-                    break ;
-                 }
+             slot = fdbTableProbe(tbl, fdbUpd.mac_address, fdbUpd.bv_id);
+             if ((tbl.index[slot] != FDB_HASH_EMPTY) &&
+                 (tbl.entries[tbl.index[slot]].egressPort == portId)) {
+                 fdbTableRemoveSlot(tbl, slot);
+                 fdbJournalAppend(tbl, MAC_DELTA_AGE,
+                                  fdbUpd.mac_address, fdbUpd.bv_id, portId);
              }
              break; 
 
@@ -132,12 +757,9 @@ void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
                      fdbNotify->attr, &portId)){
                  return; 
              }
-             for(int i = 0; i < fdbTableSize; i++) {
-                 auto &fdb = fdbTable[i];
-                 if (fdb.macAddr == fdbUpd.mac_address) {
-                    fdb.egressPort = portId; 
-                    break;
-                 }
+             slot = fdbTableProbe(tbl, fdbUpd.mac_address, fdbUpd.bv_id);
+             if (tbl.index[slot] != FDB_HASH_EMPTY) {
+                 fdbTableSetPort(tbl, tbl.index[slot], portId);
              }
              break; 
 
@@ -147,30 +769,18 @@ void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
                      fdbNotify->attr, &portId)){
 
                  // Handle port flush 
-                 int cpyIdx = 0;
-                 for(int i = 0; i < fdbTableSize; i++) {
-                     auto &fdb = fdbTable[i];
-                     if (fdb.egressPort != portId) { 
-                         fdbTable[cpyIdx++] = fdb; 
-                     }
-                 }
-                 fdbTableSize = cpyIdx;
+                 fdbTableFlushPort(tbl, portId);
+                 fdbJournalAppend(tbl, MAC_DELTA_FLUSH_PORT, 0, 0, portId);
              } else if (findVlanSaiInAttr(
                  fdbNotify->attr_count, fdbNotify->attr, &vlanSai)){ 
 
                  // Handle vlan flush 
-                 std::vector<FdbEntry> tmpFdbTable; 
-                 int cpyIdx = 0;
-                 for(int i = 0; i < fdbTableSize; i++) {
-                     auto &fdb = fdbTable[i];
-                     if (fdb.vlanSai != vlanSai) { 
-                         fdbTable[cpyIdx++] = fdb; 
-                     }
-                 }
-                 fdbTableSize = cpyIdx;
+                 fdbTableFlushVlan(tbl, vlanSai);
+                 fdbJournalAppend(tbl, MAC_DELTA_FLUSH_VLAN, 0, vlanSai, 0);
              } else {
                  // Handle complete flush.
-                 fdbTableSize = 0;
+                 fdbTableReset(tbl);
+                 fdbJournalAppend(tbl, MAC_DELTA_FLUSH_ALL, 0, 0, 0);
              }
              break; 
 
@@ -181,9 +791,364 @@ void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
                  << fdbNotify->event_type << std::endl;
              break; 
      }
+}
+
+static void fdbApplyEvent(
+    FdbTable &tbl, sai_fdb_event_notification_data_t *fdbNotify) {
+    fdbWriteBegin(tbl);
+    fdbApplyEventBody(tbl, fdbNotify);
+    fdbWriteEnd(tbl);
+    fdbMoveStormActions();
+}
+
+void esalAlterForwardingTable(sai_fdb_event_notification_data_t *fdbNotify) {
+     // Verify pointer
+     if (!fdbNotify) return; 
+
+     // Table isn't sized until the switch is up.
+     if (!fdbShadowInit) {
+         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+             SWERR_FILELINE, "FDB event before esalFdbTableInit\n"));
+         std::cout << "esalAlterForwardingTable: FDB table not initialized\n";
+         return;
+     }
+
+     fdbApplyEvent(fdbShadow, fdbNotify);
+#ifdef LARCH_ENVIRON
+     if (fdbNotify->event_type == SAI_FDB_EVENT_LEARNED) {
+         auto &mac = fdbNotify->fdb_entry.mac_address;
+         std::cout << "New Mac Learned: " << std::hex << (int) mac[0]
+                   << ":" << std::hex << (int) mac[1] << ":" << std::hex << (int) mac[2]
+                   << ":" << std::hex << (int) mac[3] << ":" << std::hex << (int) mac[4]
+                   << ":" << std::hex << (int) mac[5] << std::dec
+                   << ", vlan = " << fdbNotify->fdb_entry.bv_id
+                   << "\n";
+     }
+#endif
      return; 
 }
 
+static void fdbRingInit(FdbEventRing &ring, uint32_t depth) {
+    ring.events.resize(depth);
+    ring.mask = depth - 1;
+    ring.head.store(0);
+    ring.tail.store(0);
+    ring.enqueued.store(0);
+    ring.overflows.store(0);
+    ring.highWater.store(0);
+}
+
+// Producer side.  Returns false when the ring is full.
+static bool fdbRingPush(
+    FdbEventRing &ring, const sai_fdb_event_notification_data_t *fdbNotify) {
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if ((head - tail) > ring.mask) {
+        return false;
+    }
+
+    auto &ev = ring.events[head & ring.mask];
+    ev.eventType = fdbNotify->event_type;
+    ev.fdbEntry = fdbNotify->fdb_entry;
+    ev.attrCount = (fdbNotify->attr_count < FDB_RING_MAX_ATTRS) ?
+        fdbNotify->attr_count : FDB_RING_MAX_ATTRS;
+    for (uint32_t i = 0; i < ev.attrCount; i++) {
+        ev.attr[i] = fdbNotify->attr[i];
+    }
+    ring.head.store(head + 1, std::memory_order_release);
+
+    ring.enqueued.fetch_add(1, std::memory_order_relaxed);
+    uint32_t depth = head + 1 - tail;
+    if (depth > ring.highWater.load(std::memory_order_relaxed)) {
+        ring.highWater.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+static inline uint32_t fdbRingFree(const FdbEventRing &ring) {
+    return ring.mask + 1 - (ring.head.load(std::memory_order_relaxed) -
+                            ring.tail.load(std::memory_order_acquire));
+}
+
+// Consumer side.  Applies up to one batch under a single write section.
+static int fdbRingDrain(FdbEventRing &ring) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    int cnt = 0;
+    if (head == tail) {
+        return 0;
+    }
+
+    sai_fdb_event_notification_data_t fdbNotify;
+    fdbWriteBegin(fdbShadow);
+    while ((tail != head) && (cnt < FDB_EVENT_BATCH)) {
+        auto &ev = ring.events[tail & ring.mask];
+        fdbNotify.event_type = ev.eventType;
+        fdbNotify.fdb_entry = ev.fdbEntry;
+        fdbNotify.attr_count = ev.attrCount;
+        fdbNotify.attr = ev.attr;
+        fdbApplyEventBody(fdbShadow, &fdbNotify);
+        tail++;
+        cnt++;
+    }
+    fdbWriteEnd(fdbShadow);
+    fdbMoveStormActions();
+    ring.tail.store(tail, std::memory_order_release);
+    return cnt;
+}
+
+static void *esalFdbWorker(void*) {
+    while (!fdbWorkerLeave.load(std::memory_order_relaxed)) {
+        // Events queue up in the ring until the table has been sized.
+        if (!fdbShadowInit) {
+            usleep(FDB_WORKER_IDLE_USEC);
+            continue;
+        }
+        if (!fdbRingDrain(fdbEventRing)) {
+            fdbMoveStormRecover(fdbNowMsec());
+            fdbMoveStormActions();
+            usleep(FDB_WORKER_IDLE_USEC);
+        }
+    }
+    pthread_exit(NULL);
+    return 0;
+}
+
+bool esalFdbEventRingStart(uint32_t depth) {
+    std::lock_guard<std::mutex> lock(fdbProducerMutex);
+    if (fdbWorkerRunning) {
+        return true;
+    }
+
+    // Ring depth is rounded up to a power of two so the index is a mask.
+    // Zero means not provisioned in sai.profile.ini.
+    if (!depth) depth = FDB_RING_DEFAULT_DEPTH;
+    if (depth < FDB_RING_MIN_DEPTH) depth = FDB_RING_MIN_DEPTH;
+    if (depth > FDB_RING_MAX_DEPTH) depth = FDB_RING_MAX_DEPTH;
+    uint32_t ringDepth = FDB_RING_MIN_DEPTH;
+    while (ringDepth < depth) ringDepth <<= 1;
+
+    fdbRingInit(fdbEventRing, ringDepth);
+    fdbWorkerLeave = false;
+
+    if (pthread_create(&fdbWorkerTid, NULL, esalFdbWorker, NULL)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "pthread_create fail in esalFdbEventRingStart\n"));
+        std::cout << "ERROR esalFdbEventRingStart fail\n";
+        return false;
+    }
+    (void) pthread_setname_np(fdbWorkerTid, "ESALFdbEvent");
+    fdbWorkerRunning = true;
+    std::cout << "FDB Event Ring Depth: " << ringDepth << "\n" << std::flush;
+    return true;
+}
+
+void esalFdbEventRingStop(void) {
+    // Producers wait here until the ring is empty, then go inline.
+    std::lock_guard<std::mutex> lock(fdbProducerMutex);
+    if (!fdbWorkerRunning) {
+        return;
+    }
+    fdbWorkerLeave = true;
+    pthread_join(fdbWorkerTid, NULL);
+
+    // Nothing else writes now, so apply whatever is left behind.
+    while (fdbShadowInit && fdbRingDrain(fdbEventRing)) {}
+    fdbWorkerRunning = false;
+}
+
+void esalEnqueueFdbEvents(
+    uint32_t count, sai_fdb_event_notification_data_t *fdbNotify) {
+    if (!fdbNotify) return;
+
+    std::lock_guard<std::mutex> lock(fdbProducerMutex);
+
+    // Without the worker, the caller is the only writer.
+    if (!fdbWorkerRunning) {
+        for (uint32_t i = 0; i < count; i++) {
+            esalAlterForwardingTable(fdbNotify+i);
+        }
+        return;
+    }
+
+    // Never block the SAI event thread, count what doesn't fit.
+    for (uint32_t i = 0; i < count; i++) {
+        if (!fdbRingPush(fdbEventRing, fdbNotify+i)) {
+            fdbEventRing.overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void esalEnqueueFdbResyncEvents(
+    uint32_t count, sai_fdb_event_notification_data_t *fdbNotify) {
+    if (!fdbNotify) return;
+
+    // Warm restart replay can afford to wait for the worker to catch up,
+    // but it lets go of the producer mutex while it does, and leaves a
+    // quarter of the ring free so live events don't overflow behind it.
+    uint32_t i = 0;
+    while (i < count) {
+        {
+            std::lock_guard<std::mutex> lock(fdbProducerMutex);
+            if (!fdbWorkerRunning) {
+                for (; i < count; i++) {
+                    esalAlterForwardingTable(fdbNotify+i);
+                }
+                return;
+            }
+            uint32_t reserve = (fdbEventRing.mask + 1) / 4;
+            while ((i < count) && (fdbRingFree(fdbEventRing) > reserve) &&
+                   fdbRingPush(fdbEventRing, fdbNotify+i)) {
+                i++;
+            }
+        }
+        if (i < count) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool esalFdbEventRingStats(uint64_t *enqueued, uint64_t *overflows,
+                           uint32_t *depth, uint32_t *highWater) {
+    if (!enqueued || !overflows || !depth || !highWater) {
+        return false;
+    }
+    *enqueued = fdbEventRing.enqueued.load(std::memory_order_relaxed);
+    *overflows = fdbEventRing.overflows.load(std::memory_order_relaxed);
+    *depth = fdbEventRing.events.size();
+    *highWater = fdbEventRing.highWater.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool esalFdbTableInit(uint32_t capacity) {
+    if (fdbShadowInit) {
+        return true;
+    }
+    if (!fdbTableAlloc(fdbShadow, capacity)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "FDB arena alloc fail in esalFdbTableInit\n"));
+        std::cout << "esalFdbTableInit fail capacity: " << capacity << "\n";
+        return false;
+    }
+    fdbShadow.live = true;
+    fdbShadowInit = true;
+    std::cout << "FDB Shadow Capacity: " << fdbShadow.capacity
+              << " Arena Bytes: " << fdbShadow.arenaBytes
+              << "\n" << std::flush;
+    return true;
+}
+
+bool esalFdbTableStats(uint32_t *size, uint32_t *capacity, uint32_t *highWater,
+                       uint64_t *dropped, bool *alarm) {
+    if (!size || !capacity || !highWater || !dropped || !alarm) {
+        return false;
+    }
+    *size = fdbShadow.size;
+    *capacity = fdbShadow.capacity;
+    *highWater = fdbShadow.highWater;
+    *dropped = fdbShadow.dropped;
+    *alarm = fdbShadow.alarm;
+    return true;
+}
+
+void esalFdbMoveStormConfig(uint32_t macThreshold, uint32_t portThreshold,
+                            uint32_t holdSec, bool disableLearning) {
+    auto &ms = fdbMoveStorm;
+    ms.macThreshold = macThreshold;
+    ms.portThreshold = portThreshold;
+    ms.holdMsec = holdSec * 1000;
+    ms.disableLearning = disableLearning;
+    for (auto portId = 0; portId < FDB_PORT_BUCKETS; portId++) {
+        ms.tokens[portId] = portThreshold;
+    }
+    std::cout << "FDB Move Storm macThreshold: " << macThreshold
+              << " portThreshold: " << portThreshold
+              << " holdSec: " << holdSec
+              << " disableLearning: " << disableLearning
+              << "\n" << std::flush;
+}
+
+bool esalFdbMoveStormStats(uint64_t *moves, uint64_t *suppressedMac,
+                           uint64_t *suppressedPort, uint32_t *portsInStorm) {
+    if (!moves || !suppressedMac || !suppressedPort || !portsInStorm) {
+        return false;
+    }
+    *moves = fdbMoveStorm.moves;
+    *suppressedMac = fdbMoveStorm.suppressedMac;
+    *suppressedPort = fdbMoveStorm.suppressedPort;
+    *portsInStorm = fdbMoveStorm.portsInStorm;
+    return true;
+}
+
+bool esalFdbBenchmark(uint32_t numEvents, std::string &report) {
+    // Drive synthetic notifications through a private table so the live
+    // shadow FDB is left alone.  Bridge port OIDs must be real since the
+    // event path resolves them, so borrow them from the bridge table.
+    const int MAX_BENCH_PORTS = 8;
+    const uint32_t WORKING_SET = FDB_DEFAULT_TABLE_SIZE - 96;
+    sai_object_id_t bridgePorts[MAX_BENCH_PORTS];
+    int numPorts = 0;
+    for (uint16_t portId = 0;
+         (portId < 512) && (numPorts < MAX_BENCH_PORTS); portId++) {
+        if (esalFindBridgePortSaiFromPortId(portId, &bridgePorts[numPorts])) {
+            numPorts++;
+        }
+    }
+    if (!numPorts) {
+        report = "esalFdbBenchmark: no bridge ports available\n";
+        return false;
+    }
+
+    std::unique_ptr<FdbTable> tbl(new FdbTable());
+    if (!fdbTableAlloc(*tbl, FDB_DEFAULT_TABLE_SIZE)) {
+        report = "esalFdbBenchmark: table alloc fail\n";
+        return false;
+    }
+
+    sai_attribute_t attr;
+    attr.id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
+    sai_fdb_event_notification_data_t notify;
+    memset(&notify, 0, sizeof(notify));
+    notify.attr_count = 1;
+    notify.attr = &attr;
+    notify.fdb_entry.switch_id = esalSwitchId;
+
+    // Rounds of learn, move, then age over the working set so every
+    // event hits the hash path rather than a flush.
+    const sai_fdb_event_t roundEvents[] = {
+        SAI_FDB_EVENT_LEARNED, SAI_FDB_EVENT_MOVE, SAI_FDB_EVENT_AGED };
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numEvents; i++) {
+        uint32_t key = i % WORKING_SET;
+        uint32_t round = i / WORKING_SET;
+        sai_fdb_event_t event = roundEvents[round % 3];
+        notify.event_type = event;
+        notify.fdb_entry.mac_address[0] = 0x02;
+        notify.fdb_entry.mac_address[1] = 0x00;
+        notify.fdb_entry.mac_address[2] = (key >> 24) & 0xFF;
+        notify.fdb_entry.mac_address[3] = (key >> 16) & 0xFF;
+        notify.fdb_entry.mac_address[4] = (key >> 8) & 0xFF;
+        notify.fdb_entry.mac_address[5] = key & 0xFF;
+        notify.fdb_entry.bv_id = 1 + (key & 0xF);
+        int portIdx = (key + (event != SAI_FDB_EVENT_LEARNED)) % numPorts;
+        attr.value.oid = bridgePorts[portIdx];
+        fdbApplyEvent(*tbl, &notify);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         end - start).count();
+    std::stringstream ss;
+    ss << "esalFdbBenchmark events=" << numEvents
+       << " ports=" << numPorts
+       << " totalUsec=" << nsecs / 1000
+       << " nsecPerEvent=" << (numEvents ? nsecs / numEvents : 0)
+       << " finalSize=" << tbl->size << std::endl;
+    report = ss.str();
+    fdbTableFree(*tbl);
+    return true;
+}
+
 int VendorPurgeMacEntriesPerPort(uint16_t lPort) {
     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort << std::endl;
     int rc  = ESAL_RC_OK;
@@ -204,7 +1169,7 @@ int VendorPurgeMacEntriesPerPort(uint16_t lPort) {
     // Get the bridge API
     sai_status_t retcode;
     sai_fdb_api_t *saiFdbApi;
-    retcode =  sai_api_query(SAI_API_FDB, (void**) &saiFdbApi);
+    retcode =  esalSaiApiQuery(SAI_API_FDB, (void**) &saiFdbApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
            SWERR_FILELINE, "API Query Fail in VendorPurgeMacEntriesPerPort\n"));
@@ -254,7 +1219,7 @@ int VendorPurgeMacEntries(void) {
     //
     sai_status_t retcode;
     sai_fdb_api_t *saiFdbApi;
-    retcode =  sai_api_query(SAI_API_FDB, (void**) &saiFdbApi);
+    retcode =  esalSaiApiQuery(SAI_API_FDB, (void**) &saiFdbApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "API Query Fail in VendorPurgeMacEntries\n"));
@@ -298,18 +1263,215 @@ int VendorGetMacTbl(uint16_t lPort, uint16_t *numMacs, unsigned char *macs) {
         return ESAL_RC_FAIL;
     }
     
-    *numMacs = 0; 
-    int curMac = 0;
-    for(int i = 0; i < fdbTableSize; i++) {
-        auto &fdb = fdbTable[i];
-        if (fdb.egressPort == pPort) {
-            memcpy(macs+(*numMacs), fdb.macAddr, sizeof(sai_mac_t));
-            (*numMacs) += sizeof(sai_mac_t); 
-            if (curMac++ >= maxMacs) break;
+    // Walk only the bucket for this port, copying straight into the caller's
+    // buffer, and start over if the notification thread changed the table
+    // underneath us.  The steps are bounded so a torn list can't loop.
+    int curMac;
+    uint32_t seq;
+    do {
+        seq = fdbReadBegin(fdbShadow);
+        *numMacs = 0; 
+        curMac = 0;
+        int steps = 0;
+        int pos = fdbShadowInit ?
+            fdbShadow.portHead[fdbPortBucket(pPort)] : FDB_LINK_NONE;
+        while ((pos >= 0) && (pos < fdbShadow.capacity) &&
+               (steps++ < fdbShadow.capacity)) {
+            auto &fdb = fdbShadow.entries[pos];
+            if (fdb.egressPort == pPort) {
+                memcpy(macs+(*numMacs), fdb.macAddr, sizeof(sai_mac_t));
+                (*numMacs) += sizeof(sai_mac_t); 
+                if (curMac++ >= maxMacs) break;
+            }
+            pos = fdb.portNext;
         }
+    } while (!fdbReadValid(fdbShadow, seq));
+
+    return rc;
+}
+
+// Logical port per physical port.  The mapping is fixed once the port
+// config is read, so it is cached on first use to keep lookups O(1).
+static std::atomic<uint32_t> fdbLPortCache[FDB_PORT_BUCKETS];
+const uint32_t FDB_LPORT_UNKNOWN = 0;
+
+static bool fdbGetLogicalPort(uint16_t pPort, uint16_t *lPort) {
+    if (pPort >= FDB_PORT_BUCKETS) {
+        uint32_t port;
+        if (!saiUtils.GetLogicalPort(0, pPort, &port)) {
+            return false;
+        }
+        *lPort = port;
+        return true;
     }
 
+    // Stored as lPort + 1 so zero means not looked up yet.
+    uint32_t cached = fdbLPortCache[pPort].load(std::memory_order_relaxed);
+    if (cached == FDB_LPORT_UNKNOWN) {
+        uint32_t port;
+        if (!saiUtils.GetLogicalPort(0, pPort, &port)) {
+            return false;
+        }
+        cached = port + 1;
+        fdbLPortCache[pPort].store(cached, std::memory_order_relaxed);
+    }
+    *lPort = cached - 1;
+    return true;
+}
+
+int VendorGetMacTblDelta(uint64_t sinceGen, uint16_t *numRecs,
+                         VendorMacDelta *recs, uint64_t *curGen, bool *resync) {
+    int rc  = ESAL_RC_OK;
+
+    if (!numRecs || !recs || !curGen || !resync) {
+        return ESAL_RC_FAIL;
+    }
+    uint16_t maxRecs = *numRecs;
+    *numRecs = 0;
+    *resync = false;
+    *curGen = fdbJournalGen.load(std::memory_order_acquire);
+
+    if (!useSaiFlag){
+        return ESAL_RC_OK;
+    }
+
+    // A generation from the future means the poller predates a restart,
+    // and one older than the ring means records were overwritten.  Either
+    // way the caller must read the full table and continue from curGen.
+    uint64_t head = *curGen;
+    uint64_t oldest = (head >= FDB_JOURNAL_SIZE) ? head - FDB_JOURNAL_SIZE + 1 : 1;
+    if ((sinceGen > head) || (sinceGen + 1 < oldest)) {
+        *resync = true;
+        return rc;
+    }
+
+    uint64_t gen = sinceGen + 1;
+    uint16_t cnt = 0;
+    while ((gen <= head) && (cnt < maxRecs)) {
+        auto &rec = fdbJournal[gen & (FDB_JOURNAL_SIZE - 1)];
+        auto &out = recs[cnt];
+        out.gen = rec.gen;
+        out.op = rec.op;
+        memcpy(out.mac, rec.macAddr, sizeof(sai_mac_t));
+        out.lPort = rec.egressPort;
+        out.vlanId = (uint16_t) (GET_OID_VAL(rec.vlanSai) & 0xFFF);
+        if ((rec.op != MAC_DELTA_FLUSH_VLAN) && (rec.op != MAC_DELTA_FLUSH_ALL)) {
+            fdbGetLogicalPort(rec.egressPort, &out.lPort);
+        }
+        gen++;
+        cnt++;
+    }
+
+    // The writer may have lapped us while copying.  Anything it could have
+    // overwritten is suspect, so fall back to a resync.  That includes the
+    // slot of generation headNow+1, which may be mid-write, hence the one
+    // slot of slack over the ring size.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t headNow = fdbJournalGen.load(std::memory_order_relaxed);
+    uint64_t oldestNow =
+        (headNow + 1 >= FDB_JOURNAL_SIZE) ? headNow - FDB_JOURNAL_SIZE + 2 : 1;
+    if (cnt && ((sinceGen + 1 < oldestNow) || (recs[0].gen != sinceGen + 1))) {
+        *resync = true;
+        *curGen = headNow;
+        return rc;
+    }
+
+    *numRecs = cnt;
+    *curGen = sinceGen + cnt;
     return rc;
 }
 
+// The VLAN OID as the switch reports it in FDB events.
+static inline sai_object_id_t fdbVlanSaiFromId(uint16_t vlanId) {
+    return ((uint64_t)SAI_OBJECT_TYPE_VLAN << 48) | vlanId;
+}
+
+// Looks up one (MAC, VLAN) in the shadow.  Caller holds a read section.
+static bool fdbFindPort(const unsigned char *mac, uint16_t vlanId,
+                        uint16_t *pPort) {
+    if (!fdbShadowInit) {
+        return false;
+    }
+    const FdbTable &tbl = fdbShadow;
+    sai_object_id_t vlanSai = fdbVlanSaiFromId(vlanId);
+    uint64_t packedMac = fdbPackMac(mac);
+    int slot = fdbHashMask(tbl, packedMac, vlanSai);
+
+    // Bounded, so a read racing the writer can't spin on a torn chain.
+    for (auto steps = 0; steps <= tbl.slotMask; steps++) {
+        int32_t pos = tbl.index[slot];
+        if ((pos < 0) || (pos >= tbl.capacity)) {
+            return false;
+        }
+        auto &fdb = tbl.entries[pos];
+        if ((fdb.vlanSai == vlanSai) && (fdbPackMac(fdb.macAddr) == packedMac)) {
+            *pPort = fdb.egressPort;
+            return true;
+        }
+        slot = (slot + 1) & tbl.slotMask;
+    }
+    return false;
+}
+
+int VendorFindMac(const unsigned char *mac, uint16_t vlanId, uint16_t *lPort) {
+    if (!mac || !lPort) {
+        return ESAL_RC_FAIL;
+    }
+    if (!useSaiFlag){
+        return ESAL_RC_FAIL;
+    }
+
+    uint16_t pPort = 0;
+    bool found;
+    uint32_t seq;
+    do {
+        seq = fdbReadBegin(fdbShadow);
+        found = fdbFindPort(mac, vlanId, &pPort);
+    } while (!fdbReadValid(fdbShadow, seq));
+
+    if (!found || !fdbGetLogicalPort(pPort, lPort)) {
+        return ESAL_RC_FAIL;
+    }
+    return ESAL_RC_OK;
+}
+
+int VendorFindMacBulk(uint16_t numMacs, const unsigned char *macs,
+                      const uint16_t *vlanIds, uint16_t *lPorts,
+                      uint16_t *numFound) {
+    if (!macs || !vlanIds || !lPorts || !numFound) {
+        return ESAL_RC_FAIL;
+    }
+    *numFound = 0;
+    if (!useSaiFlag){
+        return ESAL_RC_OK;
+    }
+
+    // One read section covers the whole batch so the answers are
+    // consistent with each other.  Physical ports are held in lPorts
+    // until the snapshot is known good.
+    uint16_t cnt;
+    uint32_t seq;
+    do {
+        seq = fdbReadBegin(fdbShadow);
+        cnt = 0;
+        for (uint16_t i = 0; i < numMacs; i++) {
+            if (fdbFindPort(macs + (i * sizeof(sai_mac_t)), vlanIds[i], &lPorts[i])) {
+                cnt++;
+            } else {
+                lPorts[i] = ESAL_MAC_NOT_FOUND;
+            }
+        }
+    } while (!fdbReadValid(fdbShadow, seq));
+
+    for (uint16_t i = 0; i < numMacs; i++) {
+        if ((lPorts[i] != ESAL_MAC_NOT_FOUND) &&
+            !fdbGetLogicalPort(lPorts[i], &lPorts[i])) {
+            lPorts[i] = ESAL_MAC_NOT_FOUND;
+            cnt--;
+        }
+    }
+    *numFound = cnt;
+    return ESAL_RC_OK;
+}
+
 }
@@ -16,7 +16,21 @@
 #include <string>
 #include <cinttypes>
 #include "mutex"
+#include "atomic"
+#include "thread"
+#include <chrono>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sstream>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include "vector"
+#include "map"
 #include "string"
 
 #include "sai/sai.h"
@@ -42,20 +56,20 @@ extern "C" {
 // 
 //        - The entire table must be iterated, looking for matches on either 
 //          VLAN ID SAI Object, PORT SAI Object, or combination of both.
-//        - Filter Tables only grow.
-//        - A typical filter table is ~8 filters, maximum is 32.
+//        - A typical filter table is ~8 filters, but per service traps
+//          (DHCP, LLDP, CFM, OAM) can take it into the hundreds.
 //        - Cannot use operating system primitives for Packet Rx/Tx.
 //        - Can use operating system primitives for update
 // 
-// Therefore, there will be a "C" style arrays with entry containing two
-// fields: PORT SAI Object and VLAN ID. More importantly, there is a current
-// table size attribute.  All updates are made in the shadow area, above
-// the current table size.   Then, the current table size is incremented.
-// A sempahore protects the following sequence of code
+// Therefore, updates edit the filter table under a sempahore, then compile
+// it into a new read only snapshot and publish it with an atomic pointer
+// swap.  Packet Rx only ever reads a published snapshot, inside an epoch,
+// and the old snapshot is freed once its epoch has drained.  A sempahore
+// protects the following sequence of code
 // 
 //       o Instantiation of SAI Object.
-//       o Writing to the C Array
-//       o Bumping the C Array Size
+//       o Writing to the filter table
+//       o Compiling and publishing the snapshot
 // 
 
 const int MAC_SIZE = sizeof(sai_mac_t);
@@ -65,6 +79,14 @@ const int MAC_SIZE = sizeof(sai_mac_t);
 #define ETHERTYPE_OFFSET      16
 #define IPV4_PROTO_OFFSET     28
 #define UDP_DST_PORT_OFFSET   40
+
+// Further offsets in the same single tagged frame, for mapping raw data
+// onto ACL fields.  IPv4 is taken without options.
+#define IPV4_PROTO_FIELD_OFFSET 27
+#define IPV4_L4_SRC_PORT_OFFSET 38
+#define IPV6_NEXT_HDR_OFFSET    24
+#define IPV6_L4_SRC_PORT_OFFSET 58
+#define IPV6_L4_DST_PORT_OFFSET 60
 #ifdef LARCH_ENVIRON
 
 class  RawData {
@@ -99,219 +121,1909 @@ class EsalL2Filter {
 
     std::string &filtername() { return name; };
 
-    bool has_mac() { return false; };
+    bool has_mac() { return false; };
+
+    bool has_macmask() { return false; };
+
+    bool has_vlan() { return false; };
+
+    bool has_vlanmask() { return false; };
+
+    uint16_t vlan() { return 100; };
+
+    uint16_t vlanmask() { return 0xff; } ;
+
+    int vendorport_size() { return 1; };
+    uint32_t vendorport(int) { return 28; };
+    
+    RawData rawData;
+
+    int rawdata_size() { return 5;} //rawdata_array.size(); };
+    RawData rawdata(int index) { return rawData(index); };
+};
+// filter.rawdata(i).offset();
+
+#endif
+
+struct FilterEntry{
+    std::string filterName; 
+    EsalL2Filter filter; 
+    unsigned char mac[MAC_SIZE];
+    unsigned char macMask[MAC_SIZE];
+    bool pendingDelete; 
+    sai_object_id_t aclEntryOid;
+    sai_object_id_t aclEntryV6Oid;
+    int rxQueue;
+    uint8_t rxPriority;
+    int rxFilterSlot;
+
+};
+
+// The filter table itself is a growable vector, owned by the update path
+// and only touched under filterTableMutex.  Rx never reads it.
+const int MAX_FILTER_TABLE_SIZE = 1024;
+static std::vector<FilterEntry> filterTable;
+static std::mutex filterTableMutex;
+
+// COMPILED CLASSIFIER:
+// Whenever the filter table changes, the filters are compiled into match
+// bitmaps, bit N standing for filterTable[N].  Each packet field indexes a
+// table of filters it could satisfy, so the candidates for a packet are the
+// AND of the ingress port, VLAN and each DMAC byte lookup, and the first set
+// bit is the winner, in table order as before.  DMAC masks are per byte, so
+// the byte tables are exact.  Only raw data checks are evaluated per filter,
+// and only for candidates.
+//
+// The compiled classifier is an immutable snapshot, published by swapping
+// filterSnapshot.  Rx reads it inside an epoch (see filterReadLock) and
+// never blocks; an update waits for the readers of the old epoch to drain
+// before freeing the old snapshot.  A lookup therefore sees either the old
+// or the new filter set, never a mix.
+//
+// Raw data that falls in the first FILTER_LANE_BYTES of the frame is also
+// compiled into a value/mask row per filter, which the match kernel below
+// tests in a few vector instructions.  Anything further in falls back to
+// the per field check.
+typedef uint64_t FilterMask;
+const int FILTER_MASK_BITS = 64;
+const int MAX_CLASSIFIER_PORTS = 512;
+const int MAX_CLASSIFIER_VLANS = 4096;
+const int MAX_FILTER_RAW_DATA = 16;
+const uint32_t FILTER_LANE_BYTES = 64;
+
+// Rx worker pool priorities, see RX WORKER POOL.
+const int RX_PRIO_CONTROL = 0;
+const int RX_PRIO_DHCP = 1;
+const int RX_PRIO_OTHER = 2;
+const int RX_PRIO_LEVELS = 3;
+
+struct FilterLanes {
+    uint8_t value[FILTER_LANE_BYTES];
+    uint8_t mask[FILTER_LANE_BYTES];
+};
+
+struct CompiledRawData {
+    uint32_t offset;
+    uint32_t width;
+    uint32_t data;
+    uint32_t mask;
+};
+
+// RAW DATA PROGRAMS:
+// Raw data that does not fit the lanes is compiled into a short program
+// for a one register machine: load a big endian byte, half word or word
+// from the frame, mask it, compare it and jump forward on the result.
+// Programs are verified as they are compiled.  Every jump goes forward
+// and lands inside the program, which ends in a return, so a program runs
+// at most its own length, and the frame length is checked once against
+// the furthest load before it runs.
+enum FilterOp : uint8_t {
+    FILTER_OP_LDB,
+    FILTER_OP_LDH,
+    FILTER_OP_LDW,
+    FILTER_OP_AND,
+    FILTER_OP_JEQ,
+    FILTER_OP_RET
+};
+
+struct FilterInsn {
+    uint8_t op;
+    uint8_t jt;
+    uint8_t jf;
+    uint32_t k;
+};
+
+const uint32_t MAX_FILTER_PROGRAM = (3 * MAX_FILTER_RAW_DATA) + 2;
+const uint32_t MAX_FILTER_LOAD_END = 0xffff;
+
+struct FilterProgram {
+    uint32_t minLen;
+    std::vector<FilterInsn> insns;
+};
+
+// Ingress port resolution for Rx, indexed by GET_OID_VAL of the port
+// SAI object.  Rebuilt from the port table and the sai.cfg port map by
+// esalHostPortMapRefresh, and copied into every snapshot along with the
+// row of portMask that holds the port's candidate filters.
+const uint32_t MAX_RX_PORT_CACHE = 1024;
+
+struct RxPortEntry {
+    bool valid;
+    uint16_t pPort;
+    uint32_t lPort;
+    uint32_t maskRow;
+};
+
+static std::vector<RxPortEntry> rxPortMap;
+
+// Tx attribute templates by lPort, built alongside the Rx port map and
+// published with the same epoch, so a send is a table load and a call
+// into the hostif API.
+struct TxPortTemplate {
+    bool valid;
+    sai_attribute_t attrs[2];
+};
+
+static std::atomic<TxPortTemplate*> txPortTemplates(nullptr);
+
+static void txPortAttrsFill(sai_attribute_t *attrs, sai_object_id_t portSai) {
+    attrs[0].id = SAI_HOSTIF_PACKET_ATTR_HOSTIF_TX_TYPE;
+    attrs[0].value.s32 = SAI_HOSTIF_TX_TYPE_PIPELINE_BYPASS;
+    attrs[1].id = SAI_HOSTIF_PACKET_ATTR_EGRESS_PORT_OR_LAG;
+    attrs[1].value.oid = portSai;
+}
+
+// Bitmaps are words FilterMask wide per lookup value.  The portMask row
+// after the last classifier port holds the filters that apply to any port.
+struct FilterSnapshot {
+    int numFilters;
+    int words;
+    std::vector<std::string> names;
+    std::vector<RxPortEntry> rxPorts;      // [MAX_RX_PORT_CACHE]
+    std::vector<FilterMask> portMask;      // [MAX_CLASSIFIER_PORTS+1][words]
+    std::vector<FilterMask> vlanMask;      // [MAX_CLASSIFIER_VLANS][words]
+    std::vector<FilterMask> dmacMask;      // [MAC_SIZE][256][words]
+    std::vector<FilterMask> rawMask;       // [words]
+    std::vector<FilterMask> laneMask;      // [words]
+    std::vector<FilterProgram> progs;      // [numFilters]
+    std::vector<uint32_t> laneMinLen;      // [numFilters]
+    std::vector<FilterLanes> lanes;        // [numFilters]
+    std::vector<int> rxQueue;              // [numFilters]
+    std::vector<int> rxFilterSlot;         // [numFilters]
+    std::vector<int> rxQueueByPrio[RX_PRIO_LEVELS];
+};
+
+static std::atomic<FilterSnapshot*> filterSnapshot(nullptr);
+static std::atomic<uint32_t> filterEpoch(0);
+static std::atomic<uint32_t> filterReaders[2];
+
+static VendorRxCallback_fp_t rcvrCb;
+static void *rcvrCbId;
+sai_object_id_t hostInterface;
+
+// RX BATCHING:
+// With VendorRegisterRxBatchCb, matched packets are copied out of the SAI
+// packet event thread into a single producer/single consumer ring, and the
+// ESAL Rx batch worker hands them to the application as a vector.  A batch
+// goes out once it reaches rxBatchMaxPkts or its oldest packet has waited
+// rxBatchMaxUsec, both from sai.profile.ini.  Slots keep their buffers, so
+// a steady state burst does not allocate.  Without a batch callback, the
+// single packet callback is invoked inline as before.
+const uint32_t RX_BATCH_DEFAULT_PKTS = 32;
+const uint32_t RX_BATCH_MAX_PKTS = 256;
+const uint32_t RX_BATCH_DEFAULT_USEC = 1000;
+const uint32_t RX_BATCH_RING_DEPTH = 1024;
+
+// RX WORKER POOL:
+// With rxWorkerThreads in sai.profile.ini, every filter gets its own
+// bounded ring instead, and a pool of ESAL Rx workers drains them, so a
+// slow consumer of one trap no longer holds up the others or the SAI
+// thread.  Workers serve strictly by priority: link local control frames
+// (01:80:C2:00:00:0X, BPDU, LACP, LLDP) ahead of DHCP ahead of everything
+// else.  A worker claims a ring before draining it, so each ring keeps a
+// single consumer.  Rings are only recycled once a new snapshot no longer
+// points at them, and carry the filter name in each slot, so a recycled
+// ring still delivers its leftovers correctly.
+const uint32_t RX_QUEUE_DEFAULT_DEPTH = 256;
+const uint32_t RX_QUEUE_MIN_DEPTH = 16;
+const uint32_t RX_QUEUE_MAX_DEPTH = 8192;
+const uint32_t RX_MAX_WORKERS = 8;
+const int RX_WORKER_IDLE_USEC = 100;
+
+struct RxSlot {
+    std::string filterName;
+    uint16_t lPort;
+    uint16_t length;
+    std::vector<uint8_t> packet;
+    uint64_t stampUsec;
+};
+
+struct RxRing {
+    std::vector<RxSlot> slots;
+    uint32_t mask;
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    std::atomic<bool> busy;
+    alignas(64) std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> overflows;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint32_t> highWater;
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> latencySumUsec;
+    std::atomic<uint64_t> latencyMaxUsec;
+
+    // Owned by the update path, under filterTableMutex.
+    std::string filterName;
+    int priority;
+    bool inUse;
+};
+
+// RX POLICING:
+// Trapped packets are policed per ingress port and then per filter before
+// they are queued or delivered, so a storm on one port or one trap cannot
+// starve protocol processing for the others.  Each policer is a token
+// bucket kept as a theoretical arrival time (GCRA) in one atomic, updated
+// by compare and swap, and allows a burst of one second at its rate.  The
+// per filter state lives in a slot that follows the filter name, so the
+// bucket and its counters survive snapshot rebuilds.
+struct RxPolicer {
+    std::atomic<uint64_t> tatNsec;
+    std::atomic<uint64_t> intervalNsec;
+    std::atomic<uint64_t> toleranceNsec;
+    std::atomic<uint64_t> passed;
+    std::atomic<uint64_t> dropped;
+};
+
+struct RxFilterSlot {
+    RxPolicer policer;
+
+    // Owned by the update path, under filterTableMutex.
+    std::string filterName;
+    bool inUse;
+};
+
+struct RxMatch {
+    uint32_t lPort;
+    int rxQueue;
+    int rxFilterSlot;
+};
+
+static RxPolicer rxPortPolicers[MAX_CLASSIFIER_PORTS];
+static uint32_t rxPortPolicerPps = 0;
+static RxFilterSlot rxFilterSlots[MAX_FILTER_TABLE_SIZE];
+static std::map<std::string, uint32_t> rxFilterPolicerPps;
+
+static RxRing rxBatchRing;
+static RxRing rxQueues[MAX_FILTER_TABLE_SIZE];
+static uint32_t rxQueueDepth = RX_QUEUE_DEFAULT_DEPTH;
+static uint32_t rxWorkerCount = 0;
+static std::atomic<bool> rxPoolRunning(false);
+static std::atomic<bool> rxPoolLeave(false);
+static pthread_t rxWorkerTid[RX_MAX_WORKERS];
+static VendorRxBatchCallback_fp_t rcvrBatchCb;
+static void *rcvrBatchCbId;
+static uint32_t rxBatchMaxPkts = RX_BATCH_DEFAULT_PKTS;
+static uint32_t rxBatchMaxUsec = RX_BATCH_DEFAULT_USEC;
+static std::atomic<bool> rxBatchRunning(false);
+static std::atomic<bool> rxBatchLeave(false);
+static pthread_t rxBatchTid;
+
+// Applications registered rcvrCb and rcvrBatchCb to be called from one
+// thread.  With several Rx workers, the batch worker and the SAI thread
+// able to deliver, the calls are made one at a time under this mutex.
+static std::mutex rxDeliverMutex;
+
+
+
+static void convertMacStringToAddr(std::string &macString,
+                                   unsigned char *macAddr) {
+    int macIdx = 0;
+    memset(macAddr, 0, MAC_SIZE);
+    for(auto ch : macString) {
+        unsigned char num = 0; 
+        switch (ch) {
+            case ':':
+                macIdx++;
+                break;
+            case 'A':
+            case 'a':
+                num = 10;
+                break;
+            case 'B':
+            case 'b':
+                num = 11;
+                break;
+            case 'C':
+            case 'c':
+                num = 12;
+                break;
+            case 'D':
+            case 'd':
+                num = 13;
+                break;
+            case 'E':
+            case 'e':
+                num = 14;
+                break;
+            case 'F':
+            case 'f':
+                num = 15;
+                break;
+            default:
+                if (ch >= '0' && ch <= '9') {
+                   num = ch - '0';
+                }
+        }
+        if (macIdx <  MAC_SIZE) {
+            macAddr[macIdx] = (macAddr[macIdx]*16) + num;
+        }
+    }
+}
+
+// Tests (hdr & mask) == value over all lanes.  The value row is stored
+// pre-masked, so a match is an all zero XOR.
+static inline bool filterLanesMatchScalar(const FilterLanes &lanes,
+                                          const uint8_t *hdr) {
+    uint64_t diff = 0;
+    for (uint32_t w = 0; w < FILTER_LANE_BYTES; w += sizeof(uint64_t)) {
+        uint64_t pkt, mask, value;
+        memcpy(&pkt, hdr + w, sizeof(pkt));
+        memcpy(&mask, lanes.mask + w, sizeof(mask));
+        memcpy(&value, lanes.value + w, sizeof(value));
+        diff |= (pkt & mask) ^ value;
+    }
+    return diff == 0;
+}
+
+static inline bool filterLanesMatch(const FilterLanes &lanes,
+                                    const uint8_t *hdr) {
+#if defined(__AVX2__)
+    __m256i diff = _mm256_setzero_si256();
+    for (uint32_t w = 0; w < FILTER_LANE_BYTES; w += sizeof(__m256i)) {
+        __m256i pkt = _mm256_loadu_si256((const __m256i*) (hdr + w));
+        __m256i mask = _mm256_loadu_si256((const __m256i*) (lanes.mask + w));
+        __m256i value = _mm256_loadu_si256((const __m256i*) (lanes.value + w));
+        diff = _mm256_or_si256(diff,
+                   _mm256_xor_si256(_mm256_and_si256(pkt, mask), value));
+    }
+    return _mm256_testz_si256(diff, diff);
+#elif defined(__SSE2__)
+    __m128i diff = _mm_setzero_si128();
+    for (uint32_t w = 0; w < FILTER_LANE_BYTES; w += sizeof(__m128i)) {
+        __m128i pkt = _mm_loadu_si128((const __m128i*) (hdr + w));
+        __m128i mask = _mm_loadu_si128((const __m128i*) (lanes.mask + w));
+        __m128i value = _mm_loadu_si128((const __m128i*) (lanes.value + w));
+        diff = _mm_or_si128(diff,
+                   _mm_xor_si128(_mm_and_si128(pkt, mask), value));
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xffff;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t diff = vdupq_n_u8(0);
+    for (uint32_t w = 0; w < FILTER_LANE_BYTES; w += sizeof(uint8x16_t)) {
+        uint8x16_t pkt = vld1q_u8(hdr + w);
+        uint8x16_t mask = vld1q_u8(lanes.mask + w);
+        uint8x16_t value = vld1q_u8(lanes.value + w);
+        diff = vorrq_u8(diff, veorq_u8(vandq_u8(pkt, mask), value));
+    }
+    return vmaxvq_u8(diff) == 0;
+#else
+    return filterLanesMatchScalar(lanes, hdr);
+#endif
+}
+
+// Folds one raw data field into the filter's lanes.  Returns false if it
+// does not fit or contradicts a field already there.
+static bool compileRawDataLanes(FilterLanes &lanes, const CompiledRawData &raw) {
+    if ((raw.offset + raw.width) > FILTER_LANE_BYTES) {
+        return false;
+    }
+    for (uint32_t b = 0; b < raw.width; b++) {
+        uint32_t shift = 8 * (raw.width - 1 - b);
+        uint8_t mask = (raw.mask >> shift) & 0xff;
+        uint8_t value = (raw.data >> shift) & mask;
+        uint8_t &laneMask = lanes.mask[raw.offset + b];
+        uint8_t &laneValue = lanes.value[raw.offset + b];
+        if ((laneValue ^ value) & laneMask & mask) {
+            return false;
+        }
+        laneMask |= mask;
+        laneValue |= value;
+    }
+    return true;
+}
+
+// Reads a filter's raw data into fields.  The field width follows the
+// mask, and the field is read big endian at the offset.  Returns the field
+// count, or -1 if there are more than MAX_FILTER_RAW_DATA.
+static int decodeRawData(EsalL2Filter &fltr, CompiledRawData *fields) {
+    int rawSize = fltr.rawdata_size();
+    if (rawSize > MAX_FILTER_RAW_DATA) {
+        return -1;
+    }
+    for (int r = 0; r < rawSize; r++) {
+        CompiledRawData &raw = fields[r];
+        raw.offset = fltr.rawdata(r).offset();
+        raw.data = fltr.rawdata(r).data();
+        raw.mask = fltr.rawdata(r).mask();
+        raw.width = (raw.mask & 0xffff0000) ? 4 : (raw.mask & 0xff00) ? 2 : 1;
+        if (raw.offset == IPV4_PROTO_OFFSET) {
+            // Names the ACL protocol field, which is one byte earlier
+            // in a tagged frame.
+            raw.offset = IPV4_PROTO_FIELD_OFFSET;
+            raw.mask &= 0xff;
+            raw.width = 1;
+        }
+    }
+    return rawSize;
+}
+
+static bool filterProgramVerify(FilterProgram &prog) {
+    uint32_t num = prog.insns.size();
+    if (!num || (num > MAX_FILTER_PROGRAM) ||
+        (prog.insns[num - 1].op != FILTER_OP_RET)) {
+        return false;
+    }
+    prog.minLen = 0;
+    for (uint32_t i = 0; i < num; i++) {
+        const FilterInsn &insn = prog.insns[i];
+        uint32_t width = 0;
+        switch (insn.op) {
+            case FILTER_OP_LDB: width = 1; break;
+            case FILTER_OP_LDH: width = 2; break;
+            case FILTER_OP_LDW: width = 4; break;
+            case FILTER_OP_AND:
+            case FILTER_OP_RET:
+                break;
+            case FILTER_OP_JEQ:
+                if (((i + 1 + insn.jt) >= num) || ((i + 1 + insn.jf) >= num)) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+        if (width) {
+            if (insn.k > (MAX_FILTER_LOAD_END - width)) {
+                return false;
+            }
+            if (prog.minLen < (insn.k + width)) {
+                prog.minLen = insn.k + width;
+            }
+        }
+    }
+    return true;
+}
+
+// Emits load, mask if partial, and compare per field, every compare
+// failing to the trailing return false.  An unverifiable program never
+// matches.
+static bool compileRawDataProgram(FilterProgram &prog,
+                                  const CompiledRawData *fields, int count) {
+    prog.insns.clear();
+    for (int r = 0; r < count; r++) {
+        const CompiledRawData &raw = fields[r];
+        uint32_t full = (raw.width == 4) ? 0xffffffff :
+                        ((1u << (8 * raw.width)) - 1);
+        uint8_t op = (raw.width == 4) ? FILTER_OP_LDW :
+                     (raw.width == 2) ? FILTER_OP_LDH : FILTER_OP_LDB;
+        prog.insns.push_back({op, 0, 0, raw.offset});
+        if ((raw.mask & full) != full) {
+            prog.insns.push_back({FILTER_OP_AND, 0, 0, raw.mask});
+        }
+        prog.insns.push_back({FILTER_OP_JEQ, 0, 0, raw.data & raw.mask});
+    }
+    prog.insns.push_back({FILTER_OP_RET, 0, 0, 1});
+    prog.insns.push_back({FILTER_OP_RET, 0, 0, 0});
+
+    uint32_t fail = prog.insns.size() - 1;
+    for (uint32_t i = 0; i < fail; i++) {
+        if (prog.insns[i].op == FILTER_OP_JEQ) {
+            prog.insns[i].jf = fail - (i + 1);
+        }
+    }
+
+    if (!filterProgramVerify(prog)) {
+        prog.insns.clear();
+        prog.minLen = UINT32_MAX;
+        return false;
+    }
+    return true;
+}
+
+static bool filterProgramRun(const FilterProgram &prog,
+                             const unsigned char *pkt, sai_size_t len) {
+    if ((len < prog.minLen) || prog.insns.empty()) {
+        return false;
+    }
+    const FilterInsn *pc = prog.insns.data();
+    uint32_t a = 0;
+    for (;;) {
+        switch (pc->op) {
+            case FILTER_OP_LDB:
+                a = pkt[pc->k];
+                break;
+            case FILTER_OP_LDH:
+                a = (pkt[pc->k] << 8) | pkt[pc->k + 1];
+                break;
+            case FILTER_OP_LDW:
+                a = ((uint32_t) pkt[pc->k] << 24) | (pkt[pc->k + 1] << 16) |
+                    (pkt[pc->k + 2] << 8) | pkt[pc->k + 3];
+                break;
+            case FILTER_OP_AND:
+                a &= pc->k;
+                break;
+            case FILTER_OP_JEQ:
+                pc += (a == pc->k) ? pc->jt : pc->jf;
+                break;
+            case FILTER_OP_RET:
+                return pc->k != 0;
+            default:
+                return false;
+        }
+        pc++;
+    }
+}
+
+// Rx side of the epoch.  A reader counts itself in the current epoch's
+// slot, and retries if the epoch moved before it was counted, so an update
+// that flips the epoch only has to wait out the slot it flipped away from.
+static uint32_t filterReadLock(void) {
+    for (;;) {
+        uint32_t epoch = filterEpoch.load();
+        filterReaders[epoch & 1].fetch_add(1);
+        if (filterEpoch.load() == epoch) {
+            return epoch & 1;
+        }
+        filterReaders[epoch & 1].fetch_sub(1);
+    }
+}
+
+static void filterReadUnlock(uint32_t slot) {
+    filterReaders[slot].fetch_sub(1, std::memory_order_release);
+}
+
+// Waits until no reader can still hold a snapshot published before the
+// call.  Caller holds filterTableMutex.
+static void filterSynchronize(void) {
+    uint32_t epoch = filterEpoch.fetch_add(1);
+    while (filterReaders[epoch & 1].load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+static inline void filterMaskSet(FilterMask *mask, int i) {
+    mask[i / FILTER_MASK_BITS] |= ((FilterMask) 1) << (i % FILTER_MASK_BITS);
+}
+
+static inline bool filterMaskTest(const FilterMask *mask, int i) {
+    return (mask[i / FILTER_MASK_BITS] >> (i % FILTER_MASK_BITS)) & 1;
+}
+
+// Compiles the filter table into a new snapshot, publishes it, and frees
+// the old one once no reader can see it.  Caller holds filterTableMutex.
+static void compileFilterTable(void) {
+    FilterSnapshot *snap = new FilterSnapshot();
+    int num = filterTable.size();
+    int words = (num + FILTER_MASK_BITS - 1) / FILTER_MASK_BITS;
+    snap->numFilters = num;
+    snap->words = words;
+    snap->names.resize(num);
+    snap->portMask.assign((MAX_CLASSIFIER_PORTS + 1) * words, 0);
+    snap->vlanMask.assign(MAX_CLASSIFIER_VLANS * words, 0);
+    snap->dmacMask.assign(MAC_SIZE * 256 * words, 0);
+    snap->rawMask.assign(words, 0);
+    snap->laneMask.assign(words, 0);
+    snap->progs.resize(num);
+    snap->laneMinLen.assign(num, 0);
+    snap->lanes.resize(num);
+    snap->rxQueue.assign(num, -1);
+    snap->rxFilterSlot.assign(num, -1);
+    if (num) {
+        memset(snap->lanes.data(), 0, num * sizeof(FilterLanes));
+    }
+
+    for (int i = 0; i < num; i++) {
+        FilterEntry &entry = filterTable[i];
+        EsalL2Filter &fltr = entry.filter;
+        snap->names[i] = entry.filterName;
+
+        // Ignore if marked pending delete. 
+        if (entry.pendingDelete) continue; 
+
+        snap->rxQueue[i] = entry.rxQueue;
+        snap->rxFilterSlot[i] = entry.rxFilterSlot;
+        if (entry.rxQueue >= 0) {
+            snap->rxQueueByPrio[entry.rxPriority].push_back(entry.rxQueue);
+        }
+
+#ifndef UTS
+#ifndef LARCH_ENVIRON
+        // Raw data, in the lanes if it fits, else as a program.
+        CompiledRawData fields[MAX_FILTER_RAW_DATA];
+        int rawSize = decodeRawData(fltr, fields);
+        if (rawSize < 0) {
+            SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                SWERR_FILELINE, "too much raw data in compileFilterTable\n"));
+            std::cout << "Packet Filter raw data exceeds " << MAX_FILTER_RAW_DATA
+                      << ": " << entry.filterName << std::endl;
+            continue;
+        }
+        bool inLanes = true;
+        for (auto r = 0; r < rawSize; r++) {
+            const CompiledRawData &raw = fields[r];
+            inLanes = inLanes && compileRawDataLanes(snap->lanes[i], raw);
+            if (snap->laneMinLen[i] < (raw.offset + raw.width)) {
+                snap->laneMinLen[i] = raw.offset + raw.width;
+            }
+        }
+        if (rawSize) {
+            filterMaskSet(snap->rawMask.data(), i);
+            if (inLanes) {
+                filterMaskSet(snap->laneMask.data(), i);
+            } else if (!compileRawDataProgram(snap->progs[i], fields, rawSize)) {
+                SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                    SWERR_FILELINE, "bad raw data in compileFilterTable\n"));
+                std::cout << "Packet Filter raw data out of range: "
+                          << entry.filterName << std::endl;
+            }
+        }
+#endif
+#endif
+
+        // Ports, no list means any port.
+        auto vpsize = fltr.vendorport_size(); 
+        if (vpsize) {
+            for (int vpidx = 0; vpidx < vpsize; vpidx++) {
+                uint32_t lPort = fltr.vendorport(vpidx);
+                if (lPort < MAX_CLASSIFIER_PORTS) {
+                    filterMaskSet(&snap->portMask[lPort * words], i);
+                }
+            }
+        } else {
+            for (int lPort = 0; lPort <= MAX_CLASSIFIER_PORTS; lPort++) {
+                filterMaskSet(&snap->portMask[lPort * words], i);
+            }
+        }
+
+        // VLAN present.
+        uint16_t vlanMask = 0;
+        uint16_t vlanMatch = 0;
+        if (fltr.has_vlan()) {
+            vlanMask =  0xfff;
+            if (fltr.has_vlanmask()) {
+                vlanMask = fltr.vlanmask();
+            }
+            vlanMatch = fltr.vlan() & vlanMask;
+        }
+        for (int vlan = 0; vlan < MAX_CLASSIFIER_VLANS; vlan++) {
+            if ((vlan & vlanMask) == vlanMatch) {
+                filterMaskSet(&snap->vlanMask[vlan * words], i);
+            }
+        }
+
+        // DMAC, each byte compared under its own mask.
+        unsigned char macMatch[MAC_SIZE] = {0, 0, 0, 0, 0, 0};
+        unsigned char macMask[MAC_SIZE] = {0, 0, 0, 0, 0, 0};
+#ifndef UTS
+        if (fltr.has_mac()) {
+            memcpy(macMatch, entry.mac, MAC_SIZE);
+            memset(macMask, 0xff, MAC_SIZE);
+            if (fltr.has_macmask()) {
+                memcpy(macMask, entry.macMask, MAC_SIZE);
+            }
+        }
+#endif
+        for (int b = 0; b < MAC_SIZE; b++) {
+            for (int val = 0; val < 256; val++) {
+                if ((val & macMask[b]) == (macMatch[b] & macMask[b])) {
+                    filterMaskSet(&snap->dmacMask[((b * 256) + val) * words], i);
+                }
+            }
+        }
+    }
+
+    snap->rxPorts = rxPortMap;
+    for (auto &port : snap->rxPorts) {
+        port.maskRow = (port.lPort < MAX_CLASSIFIER_PORTS) ?
+                        port.lPort : MAX_CLASSIFIER_PORTS;
+    }
+
+    FilterSnapshot *old = filterSnapshot.exchange(snap);
+    filterSynchronize();
+    delete old;
+}
+
+static bool searchFilterTable(sai_object_id_t portSai, RxMatch &rxMatch,
+                              std::string &fname,
+                              const void *buffer, sai_size_t bufferSz) {
+    const unsigned char *bufPtr = (const unsigned char*) buffer;
+ 
+    // Check to see that the buffer is bigger than minimum size
+    if (bufferSz < ((2*MAC_SIZE)+2+2)) {
+        return false;
+    }
+
+    // Buffer is packet with the following format:
+    //    
+    //    DST MAC: 6 bytes
+    //    SRC MAC: 6 bytes
+    //    VLAN Type: 2 bytes ... must be 0x8100
+    //    VLAN ID: 2 bytes
+    //    Ether Type for packet : 2 bytes
+
+    // Get VLAN. 
+    uint16_t vlan = 0;
+    if ((bufPtr[12] == 0x81) && (bufPtr[13] == 0x00)) {
+        vlan = ((bufPtr[14] << 8) | bufPtr[15]) & 0xfff;
+    }
+
+    // Lanes read a full header, so pad out a short frame.
+    uint8_t padded[FILTER_LANE_BYTES];
+    const uint8_t *hdr = bufPtr;
+    if (bufferSz < FILTER_LANE_BYTES) {
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, bufPtr, bufferSz);
+        hdr = padded;
+    }
+
+    uint32_t slot = filterReadLock();
+    const FilterSnapshot *snap = filterSnapshot.load(std::memory_order_acquire);
+    if (!snap) {
+        filterReadUnlock(slot);
+        return false;
+    }
+
+    // Resolve the ingress port, the slow way if it is not cached.
+    uint32_t &lPort = rxMatch.lPort;
+    uint32_t maskRow;
+    uint64_t oidVal = GET_OID_VAL(portSai);
+    if ((oidVal < MAX_RX_PORT_CACHE) && snap->rxPorts[oidVal].valid) {
+        lPort = snap->rxPorts[oidVal].lPort;
+        maskRow = snap->rxPorts[oidVal].maskRow;
+    } else {
+        uint16_t portId = 0;
+        if (!esalPortTableFindId(portSai, &portId) ||
+            !saiUtils.GetLogicalPort(0, portId, &lPort)) {
+            filterReadUnlock(slot);
+            return false;
+        }
+        maskRow = (lPort < MAX_CLASSIFIER_PORTS) ? lPort : MAX_CLASSIFIER_PORTS;
+    }
+
+    int words = snap->words;
+    if (!words) {
+        filterReadUnlock(slot);
+        return false;
+    }
+    const FilterMask *portMask = &snap->portMask[maskRow * words];
+    const FilterMask *vlanMask = &snap->vlanMask[vlan * words];
+    const FilterMask *dmac[MAC_SIZE];
+    for (int b = 0; b < MAC_SIZE; b++) {
+        dmac[b] = &snap->dmacMask[((b * 256) + bufPtr[b]) * words];
+    }
+
+    // Lowest index wins.  Only filters with raw data need a closer look.
+    bool found = false;
+    for (int w = 0; (w < words) && !found; w++) {
+        FilterMask cand = portMask[w] & vlanMask[w] &
+                          dmac[0][w] & dmac[1][w] & dmac[2][w] &
+                          dmac[3][w] & dmac[4][w] & dmac[5][w];
+        while (cand) {
+            int i = (w * FILTER_MASK_BITS) + __builtin_ctzll(cand);
+            bool match;
+            if (!filterMaskTest(snap->rawMask.data(), i)) {
+                match = true;
+            } else if (filterMaskTest(snap->laneMask.data(), i)) {
+                match = (snap->laneMinLen[i] <= bufferSz) &&
+                        filterLanesMatch(snap->lanes[i], hdr);
+            } else {
+                match = filterProgramRun(snap->progs[i], bufPtr, bufferSz);
+            }
+            if (match) {
+                fname = snap->names[i];
+                rxMatch.rxQueue = snap->rxQueue[i];
+                rxMatch.rxFilterSlot = snap->rxFilterSlot[i];
+                found = true;
+                break;
+            }
+            cand &= cand - 1;
+        }
+    }
+    filterReadUnlock(slot);
+
+    return found;
+}
+
+void esalHostPortMapRefresh(void) {
+    std::vector<RxPortEntry> ports(MAX_RX_PORT_CACHE);
+    memset(ports.data(), 0, ports.size() * sizeof(RxPortEntry));
+    TxPortTemplate *txPorts = new TxPortTemplate[MAX_CLASSIFIER_PORTS];
+    memset(txPorts, 0, MAX_CLASSIFIER_PORTS * sizeof(TxPortTemplate));
+    for (uint16_t portId = 0; portId < MAX_RX_PORT_CACHE; portId++) {
+        sai_object_id_t portSai;
+        uint32_t lPort;
+        if (!esalPortTableFindSai(portId, &portSai)) {
+            continue;
+        }
+        if (!saiUtils.GetLogicalPort(0, portId, &lPort)) {
+            continue;
+        }
+        if (lPort < MAX_CLASSIFIER_PORTS) {
+            txPortAttrsFill(txPorts[lPort].attrs, portSai);
+            txPorts[lPort].valid = true;
+        }
+        uint64_t oidVal = GET_OID_VAL(portSai);
+        if (oidVal >= MAX_RX_PORT_CACHE) {
+            continue;
+        }
+        ports[oidVal].valid = true;
+        ports[oidVal].pPort = portId;
+        ports[oidVal].lPort = lPort;
+    }
+
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    rxPortMap.swap(ports);
+    TxPortTemplate *oldTxPorts = txPortTemplates.exchange(txPorts);
+    compileFilterTable();
+    delete [] oldTxPorts;
+}
+
+bool esalFilterMatchBenchmark(uint32_t numPackets, std::string &report) {
+    // Filters mirror the DHCP trap: DMAC, TPID, VLAN, Ethertype, protocol
+    // and UDP port, all inside the lane window.  Packets hit a random
+    // filter or none, and each packet is tested against every filter as
+    // the search would.
+    const int FIELDS = 6;
+    const uint32_t offsets[FIELDS] = { 0, 12, 14, 16, 27, 40 };
+    const uint32_t masks[FIELDS] = { 0xffffffff, 0xffff, 0x0fff, 0xffff,
+                                     0xff, 0xffff };
+    const uint32_t sizes[] = { 8, 32, 256 };
+    const uint32_t NUM_SAMPLES = 64;
+
+    std::stringstream ss;
+    uint32_t seed = 0x9e3779b9;
+    auto rnd = [&seed]() {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        return seed;
+    };
+
+    for (auto numFilters : sizes) {
+        std::vector<CompiledRawData> raw(numFilters * FIELDS);
+        std::vector<FilterProgram> progs(numFilters);
+        std::vector<FilterLanes> lanes(numFilters);
+        memset(lanes.data(), 0, numFilters * sizeof(FilterLanes));
+        for (uint32_t f = 0; f < numFilters; f++) {
+            for (int r = 0; r < FIELDS; r++) {
+                CompiledRawData &field = raw[f * FIELDS + r];
+                field.offset = offsets[r];
+                field.mask = masks[r];
+                field.width = (masks[r] & 0xffff0000) ? 4 :
+                              (masks[r] & 0xff00) ? 2 : 1;
+                field.data = rnd() & masks[r];
+                compileRawDataLanes(lanes[f], field);
+            }
+            compileRawDataProgram(progs[f], &raw[f * FIELDS], FIELDS);
+        }
+
+        std::vector<uint8_t> pkts(NUM_SAMPLES * FILTER_LANE_BYTES);
+        for (uint32_t p = 0; p < NUM_SAMPLES; p++) {
+            uint8_t *pkt = &pkts[p * FILTER_LANE_BYTES];
+            for (uint32_t b = 0; b < FILTER_LANE_BYTES; b++) {
+                pkt[b] = rnd() & 0xff;
+            }
+            if (p & 1) {
+                uint32_t f = rnd() % numFilters;
+                for (uint32_t b = 0; b < FILTER_LANE_BYTES; b++) {
+                    pkt[b] = (pkt[b] & ~lanes[f].mask[b]) | lanes[f].value[b];
+                }
+            }
+        }
+
+        // Per field loop, program, scalar lanes, then the vector kernel.
+        const int PATHS = 4;
+        uint64_t nsecs[PATHS];
+        uint64_t hits[PATHS];
+        for (int k = 0; k < PATHS; k++) {
+            hits[k] = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < numPackets; i++) {
+                const uint8_t *pkt = &pkts[(i % NUM_SAMPLES) * FILTER_LANE_BYTES];
+                for (uint32_t f = 0; f < numFilters; f++) {
+                    bool match;
+                    if (k == 0) {
+                        match = true;
+                        for (int r = 0; (r < FIELDS) && match; r++) {
+                            const CompiledRawData &field = raw[f * FIELDS + r];
+                            uint32_t val = 0;
+                            for (uint32_t b = 0; b < field.width; b++) {
+                                val = (val << 8) | pkt[field.offset + b];
+                            }
+                            match = (val & field.mask) == field.data;
+                        }
+                    } else if (k == 1) {
+                        match = filterProgramRun(progs[f], pkt,
+                                                 FILTER_LANE_BYTES);
+                    } else if (k == 2) {
+                        match = filterLanesMatchScalar(lanes[f], pkt);
+                    } else {
+                        match = filterLanesMatch(lanes[f], pkt);
+                    }
+                    if (match) {
+                        hits[k]++;
+                        break;
+                    }
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            nsecs[k] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           end - start).count();
+        }
+
+        ss << "esalFilterMatchBenchmark filters=" << numFilters
+           << " packets=" << numPackets
+           << " nsecPerPkt loop=" << (numPackets ? nsecs[0] / numPackets : 0)
+           << " program=" << (numPackets ? nsecs[1] / numPackets : 0)
+           << " scalar=" << (numPackets ? nsecs[2] / numPackets : 0)
+           << " vector=" << (numPackets ? nsecs[3] / numPackets : 0)
+           << " hits=" << hits[0] << "/" << hits[1] << "/" << hits[2]
+           << "/" << hits[3]
+           << std::endl;
+    }
+    report = ss.str();
+    return true;
+}
+
+static uint64_t rxNowUsec(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t rxNowNsec(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A packet conforms if it is due no later than the burst tolerance ahead
+// of now, and then pushes the next due time out by one interval.
+static bool rxPolicerAllow(RxPolicer &policer, uint64_t nowNsec) {
+    uint64_t interval = policer.intervalNsec.load(std::memory_order_relaxed);
+    if (!interval) {
+        return true;
+    }
+    uint64_t tolerance = policer.toleranceNsec.load(std::memory_order_relaxed);
+    uint64_t tat = policer.tatNsec.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t start = (tat > nowNsec) ? tat : nowNsec;
+        if ((start - nowNsec) > tolerance) {
+            policer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (policer.tatNsec.compare_exchange_weak(tat, start + interval,
+                                                  std::memory_order_relaxed)) {
+            policer.passed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+static void rxPolicerSet(RxPolicer &policer, uint32_t pps) {
+    uint64_t interval = pps ? (1000000000ULL / pps) : 0;
+    policer.intervalNsec.store(interval, std::memory_order_relaxed);
+    policer.toleranceNsec.store(interval * pps, std::memory_order_relaxed);
+    policer.tatNsec.store(0, std::memory_order_relaxed);
+}
+
+static void rxPolicerClear(RxPolicer &policer) {
+    policer.passed.store(0, std::memory_order_relaxed);
+    policer.dropped.store(0, std::memory_order_relaxed);
+}
+
+// RX STATISTICS:
+// Hits and bytes per filter, by Rx filter slot, misses per ingress port,
+// and a latency histogram of esalHandleSaiHostRxPacket.  Counters are
+// split into RX_STAT_SHARDS shards and each thread sticks to one, so the
+// packet path only adds relaxed increments to lines other Rx threads do
+// not write.  Readers sum the shards.
+//
+// The histogram is log linear, as in HDR histograms: each power of two of
+// nanoseconds is split into RX_LAT_SUB_BUCKETS buckets, so a bucket is
+// within 1/RX_LAT_SUB_BUCKETS of the values it counts.
+const int RX_STAT_SHARDS = 8;
+const int RX_LAT_SUB_BITS = 3;
+const int RX_LAT_SUB_BUCKETS = 1 << RX_LAT_SUB_BITS;
+const int RX_LAT_MAX_EXP = 40;
+const int RX_LAT_BUCKETS = (RX_LAT_MAX_EXP - RX_LAT_SUB_BITS + 2) *
+                           RX_LAT_SUB_BUCKETS;
+
+// Misses on a port that did not resolve count in the last row.
+struct alignas(64) RxStatShard {
+    std::atomic<uint64_t> hits[MAX_FILTER_TABLE_SIZE];
+    std::atomic<uint64_t> bytes[MAX_FILTER_TABLE_SIZE];
+    std::atomic<uint64_t> misses[MAX_CLASSIFIER_PORTS + 1];
+    std::atomic<uint64_t> latency[RX_LAT_BUCKETS];
+};
+
+static RxStatShard rxStats[RX_STAT_SHARDS];
+static std::atomic<uint32_t> rxStatNextShard(0);
+
+static inline RxStatShard &rxStatShard(void) {
+    static thread_local int shard =
+        rxStatNextShard.fetch_add(1, std::memory_order_relaxed) % RX_STAT_SHARDS;
+    return rxStats[shard];
+}
+
+static inline int rxLatencyBucket(uint64_t nsec) {
+    if (nsec < (uint64_t) RX_LAT_SUB_BUCKETS) {
+        return nsec;
+    }
+    int exp = 63 - __builtin_clzll(nsec);
+    if (exp > RX_LAT_MAX_EXP) {
+        return RX_LAT_BUCKETS - 1;
+    }
+    return ((exp - RX_LAT_SUB_BITS + 1) * RX_LAT_SUB_BUCKETS) +
+           ((nsec >> (exp - RX_LAT_SUB_BITS)) & (RX_LAT_SUB_BUCKETS - 1));
+}
+
+// Largest value counted in a bucket.
+static uint64_t rxLatencyBucketMax(int bucket) {
+    if (bucket < RX_LAT_SUB_BUCKETS) {
+        return bucket;
+    }
+    int exp = (bucket / RX_LAT_SUB_BUCKETS) + RX_LAT_SUB_BITS - 1;
+    uint64_t sub = bucket % RX_LAT_SUB_BUCKETS;
+    uint64_t unit = 1ULL << (exp - RX_LAT_SUB_BITS);
+    return ((RX_LAT_SUB_BUCKETS + sub) * unit) + unit - 1;
+}
+
+// Times esalHandleSaiHostRxPacket from entry to whichever return.
+struct RxLatencyTimer {
+    uint64_t startNsec;
+    RxLatencyTimer() : startNsec(rxNowNsec()) {}
+    ~RxLatencyTimer() {
+        int bucket = rxLatencyBucket(rxNowNsec() - startNsec);
+        rxStatShard().latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+static void rxStatsClearFilter(int rxFilterSlot) {
+    for (auto &shard : rxStats) {
+        shard.hits[rxFilterSlot].store(0, std::memory_order_relaxed);
+        shard.bytes[rxFilterSlot].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool esalHostRxStatsSnapshot(EsalRxStatsSnapshot &snap) {
+    snap.filters.clear();
+    snap.portMisses.assign(MAX_CLASSIFIER_PORTS + 1, 0);
+    snap.latency.clear();
+    snap.latencyCount = 0;
+    snap.latencyP50Nsec = 0;
+    snap.latencyP99Nsec = 0;
+    snap.latencyP999Nsec = 0;
+    snap.latencyMaxNsec = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(filterTableMutex);
+        for (int i = 0; i < MAX_FILTER_TABLE_SIZE; i++) {
+            if (!rxFilterSlots[i].inUse) {
+                continue;
+            }
+            EsalRxFilterStats stats = {rxFilterSlots[i].filterName, 0, 0};
+            for (auto &shard : rxStats) {
+                stats.hits += shard.hits[i].load(std::memory_order_relaxed);
+                stats.bytes += shard.bytes[i].load(std::memory_order_relaxed);
+            }
+            snap.filters.push_back(stats);
+        }
+    }
+
+    for (auto &shard : rxStats) {
+        for (int p = 0; p <= MAX_CLASSIFIER_PORTS; p++) {
+            snap.portMisses[p] += shard.misses[p].load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t counts[RX_LAT_BUCKETS];
+    for (int b = 0; b < RX_LAT_BUCKETS; b++) {
+        counts[b] = 0;
+        for (auto &shard : rxStats) {
+            counts[b] += shard.latency[b].load(std::memory_order_relaxed);
+        }
+        if (counts[b]) {
+            snap.latency.push_back(std::make_pair(rxLatencyBucketMax(b),
+                                                  counts[b]));
+            snap.latencyCount += counts[b];
+            snap.latencyMaxNsec = rxLatencyBucketMax(b);
+        }
+    }
+
+    // Percentiles are the bound of the bucket they fall in.
+    uint64_t seen = 0;
+    for (auto &bucket : snap.latency) {
+        seen += bucket.second;
+        if (!snap.latencyP50Nsec && ((seen * 2) >= snap.latencyCount)) {
+            snap.latencyP50Nsec = bucket.first;
+        }
+        if (!snap.latencyP99Nsec && ((seen * 100) >= (snap.latencyCount * 99))) {
+            snap.latencyP99Nsec = bucket.first;
+        }
+        if (!snap.latencyP999Nsec &&
+            ((seen * 1000) >= (snap.latencyCount * 999))) {
+            snap.latencyP999Nsec = bucket.first;
+        }
+    }
+    return true;
+}
+
+bool esalHostRxStats(std::string &report) {
+    EsalRxStatsSnapshot snap;
+    esalHostRxStatsSnapshot(snap);
+
+    std::stringstream ss;
+    for (auto &filter : snap.filters) {
+        ss << "filter=" << filter.filterName << " hits=" << filter.hits
+           << " bytes=" << filter.bytes << std::endl;
+    }
+    for (int p = 0; p <= MAX_CLASSIFIER_PORTS; p++) {
+        if (!snap.portMisses[p]) {
+            continue;
+        }
+        if (p < MAX_CLASSIFIER_PORTS) {
+            ss << "lPort=" << p;
+        } else {
+            ss << "lPort=unknown";
+        }
+        ss << " misses=" << snap.portMisses[p] << std::endl;
+    }
+    ss << "latency count=" << snap.latencyCount
+       << " p50Nsec=" << snap.latencyP50Nsec
+       << " p99Nsec=" << snap.latencyP99Nsec
+       << " p999Nsec=" << snap.latencyP999Nsec
+       << " maxNsec=" << snap.latencyMaxNsec << std::endl;
+    for (auto &bucket : snap.latency) {
+        ss << "  <=" << bucket.first << "ns " << bucket.second << std::endl;
+    }
+    report = ss.str();
+    return true;
+}
+
+void esalHostRxStatsClear(void) {
+    for (auto &shard : rxStats) {
+        for (int i = 0; i < MAX_FILTER_TABLE_SIZE; i++) {
+            shard.hits[i].store(0, std::memory_order_relaxed);
+            shard.bytes[i].store(0, std::memory_order_relaxed);
+        }
+        for (int p = 0; p <= MAX_CLASSIFIER_PORTS; p++) {
+            shard.misses[p].store(0, std::memory_order_relaxed);
+        }
+        for (int b = 0; b < RX_LAT_BUCKETS; b++) {
+            shard.latency[b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Takes a free slot for a new filter.  Caller holds filterTableMutex.
+static int rxFilterSlotAlloc(const std::string &filterName) {
+    for (int i = 0; i < MAX_FILTER_TABLE_SIZE; i++) {
+        RxFilterSlot &slot = rxFilterSlots[i];
+        if (slot.inUse) {
+            continue;
+        }
+        auto rate = rxFilterPolicerPps.find(filterName);
+        rxPolicerSet(slot.policer,
+                     (rate != rxFilterPolicerPps.end()) ? rate->second : 0);
+        rxPolicerClear(slot.policer);
+        rxStatsClearFilter(i);
+        slot.filterName = filterName;
+        slot.inUse = true;
+        return i;
+    }
+    return -1;
+}
+
+void esalHostRxPortPolicerConfig(uint32_t pps) {
+    rxPortPolicerPps = pps;
+    for (auto &policer : rxPortPolicers) {
+        rxPolicerSet(policer, pps);
+    }
+    std::cout << "Rx Port Policer pps: " << pps << "\n" << std::flush;
+}
+
+void esalHostRxFilterPolicerConfig(const std::string &filterName, uint32_t pps) {
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    rxFilterPolicerPps[filterName] = pps;
+    for (auto &slot : rxFilterSlots) {
+        if (slot.inUse && (slot.filterName == filterName)) {
+            rxPolicerSet(slot.policer, pps);
+        }
+    }
+    std::cout << "Rx Filter Policer " << filterName
+              << " pps: " << pps << "\n" << std::flush;
+}
+
+bool esalHostRxPolicerStats(std::string &report) {
+    std::stringstream ss;
+    ss << "rxPortPolicerPps=" << rxPortPolicerPps << std::endl;
+    for (int lPort = 0; lPort < MAX_CLASSIFIER_PORTS; lPort++) {
+        RxPolicer &policer = rxPortPolicers[lPort];
+        uint64_t passed = policer.passed.load(std::memory_order_relaxed);
+        uint64_t dropped = policer.dropped.load(std::memory_order_relaxed);
+        if (passed || dropped) {
+            ss << "lPort=" << lPort << " passed=" << passed
+               << " dropped=" << dropped << std::endl;
+        }
+    }
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    for (auto &slot : rxFilterSlots) {
+        if (!slot.inUse) {
+            continue;
+        }
+        uint64_t interval = slot.policer.intervalNsec.load(std::memory_order_relaxed);
+        ss << "filter=" << slot.filterName
+           << " pps=" << (interval ? 1000000000ULL / interval : 0)
+           << " passed=" << slot.policer.passed.load(std::memory_order_relaxed)
+           << " dropped=" << slot.policer.dropped.load(std::memory_order_relaxed)
+           << std::endl;
+    }
+    report = ss.str();
+    return true;
+}
+
+static void rxRingInit(RxRing &ring, uint32_t depth) {
+    ring.slots.resize(depth);
+    ring.mask = depth - 1;
+    ring.head.store(0);
+    ring.tail.store(0);
+    ring.busy.store(false);
+    ring.enqueued.store(0);
+    ring.overflows.store(0);
+    ring.batches.store(0);
+    ring.highWater.store(0);
+    ring.delivered.store(0);
+    ring.latencySumUsec.store(0);
+    ring.latencyMaxUsec.store(0);
+}
+
+// Producer side, on the SAI packet event thread.
+static bool rxRingPush(RxRing &ring, const std::string &fname, uint32_t lPort,
+                       const void *buffer, sai_size_t bufferSz) {
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if ((head - tail) > ring.mask) {
+        ring.overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto &slot = ring.slots[head & ring.mask];
+    slot.filterName = fname;
+    slot.lPort = lPort;
+    slot.length = (uint16_t) bufferSz;
+    slot.packet.assign((const uint8_t*) buffer,
+                       (const uint8_t*) buffer + slot.length);
+    slot.stampUsec = rxNowUsec();
+    ring.head.store(head + 1, std::memory_order_release);
+    ring.enqueued.fetch_add(1, std::memory_order_relaxed);
+    uint32_t depth = head + 1 - tail;
+    if (depth > ring.highWater.load(std::memory_order_relaxed)) {
+        ring.highWater.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// Consumer side.  Hands cnt packets from the tail to the application, as
+// one batch if a batch callback is registered.  The slots are only released
+// once the callback has returned.
+static void rxRingDeliver(RxRing &ring, uint32_t tail, uint32_t cnt) {
+    uint64_t now = rxNowUsec();
+    uint64_t latencyMax = ring.latencyMaxUsec.load(std::memory_order_relaxed);
+    uint64_t latencySum = 0;
+    VendorRxPacket pkts[RX_BATCH_MAX_PKTS];
+    for (uint32_t i = 0; i < cnt; i++) {
+        auto &slot = ring.slots[(tail + i) & ring.mask];
+        pkts[i].filterName = slot.filterName.c_str();
+        pkts[i].lPort = slot.lPort;
+        pkts[i].length = slot.length;
+        pkts[i].packet = slot.packet.data();
+        uint64_t latency = now - slot.stampUsec;
+        latencySum += latency;
+        if (latency > latencyMax) latencyMax = latency;
+    }
+    ring.latencySumUsec.fetch_add(latencySum, std::memory_order_relaxed);
+    ring.latencyMaxUsec.store(latencyMax, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(rxDeliverMutex);
+        if (rcvrBatchCb) {
+            rcvrBatchCb(rcvrBatchCbId, cnt, pkts);
+        } else if (rcvrCb) {
+            for (uint32_t i = 0; i < cnt; i++) {
+                (void) rcvrCb(rcvrCbId, pkts[i].filterName, pkts[i].lPort,
+                              pkts[i].length, pkts[i].packet);
+            }
+        }
+    }
+    ring.batches.fetch_add(1, std::memory_order_relaxed);
+    ring.delivered.fetch_add(cnt, std::memory_order_relaxed);
+    ring.tail.store(tail + cnt, std::memory_order_release);
+}
+
+// Batch worker side.  Delivers one batch if it is due, or unconditionally
+// when forced.
+static uint32_t rxBatchFlush(bool force) {
+    auto &ring = rxBatchRing;
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    uint32_t cnt = head - tail;
+    if (!cnt) {
+        return 0;
+    }
+    if (cnt > rxBatchMaxPkts) {
+        cnt = rxBatchMaxPkts;
+    }
+    if (!force && (cnt < rxBatchMaxPkts) &&
+        ((rxNowUsec() - ring.slots[tail & ring.mask].stampUsec) < rxBatchMaxUsec)) {
+        return 0;
+    }
+
+    rxRingDeliver(ring, tail, cnt);
+    return cnt;
+}
+
+// Claims a ring and delivers up to a batch from it.  Returns 0 if the ring
+// is empty or another worker has it.
+static uint32_t rxQueueDrain(RxRing &ring) {
+    if (ring.head.load(std::memory_order_acquire) ==
+        ring.tail.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    if (ring.busy.exchange(true, std::memory_order_acquire)) {
+        return 0;
+    }
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t cnt = ring.head.load(std::memory_order_acquire) - tail;
+    if (cnt > rxBatchMaxPkts) {
+        cnt = rxBatchMaxPkts;
+    }
+    if (cnt) {
+        rxRingDeliver(ring, tail, cnt);
+    }
+    ring.busy.store(false, std::memory_order_release);
+    return cnt;
+}
+
+// Picks the first ring with work, highest priority first.  The snapshot
+// is only held for the pick, the delivery runs outside the epoch.
+static RxRing *rxQueuePick(void) {
+    RxRing *ring = nullptr;
+    uint32_t slot = filterReadLock();
+    const FilterSnapshot *snap = filterSnapshot.load(std::memory_order_acquire);
+    for (int prio = 0; snap && !ring && (prio < RX_PRIO_LEVELS); prio++) {
+        for (auto q : snap->rxQueueByPrio[prio]) {
+            RxRing *cand = &rxQueues[q];
+            if ((cand->head.load(std::memory_order_acquire) !=
+                 cand->tail.load(std::memory_order_relaxed)) &&
+                !cand->busy.load(std::memory_order_relaxed)) {
+                ring = cand;
+                break;
+            }
+        }
+    }
+    filterReadUnlock(slot);
+    return ring;
+}
+
+static void *esalRxWorker(void*) {
+    while (!rxPoolLeave.load(std::memory_order_relaxed)) {
+        // Back off whenever nothing was drained, including when the
+        // picked ring is being drained by another worker.
+        RxRing *ring = rxQueuePick();
+        if (!ring || !rxQueueDrain(*ring)) {
+            usleep(RX_WORKER_IDLE_USEC);
+        }
+    }
+    pthread_exit(NULL);
+    return 0;
+}
+
+void esalHostRxPoolConfig(uint32_t workers, uint32_t queueDepth) {
+    if (rxPoolRunning) {
+        return;
+    }
+    if (workers > RX_MAX_WORKERS) workers = RX_MAX_WORKERS;
+    if (!queueDepth) queueDepth = RX_QUEUE_DEFAULT_DEPTH;
+    if (queueDepth < RX_QUEUE_MIN_DEPTH) queueDepth = RX_QUEUE_MIN_DEPTH;
+    if (queueDepth > RX_QUEUE_MAX_DEPTH) queueDepth = RX_QUEUE_MAX_DEPTH;
+    uint32_t depth = RX_QUEUE_MIN_DEPTH;
+    while (depth < queueDepth) depth <<= 1;
+    rxWorkerCount = workers;
+    rxQueueDepth = depth;
+    std::cout << "Rx Worker Threads: " << rxWorkerCount
+              << " Queue Depth: " << rxQueueDepth << "\n" << std::flush;
+}
+
+bool esalHostRxPoolStart(void) {
+    if (rxPoolRunning || !rxWorkerCount) {
+        return true;
+    }
+    rxPoolLeave = false;
+    for (uint32_t i = 0; i < rxWorkerCount; i++) {
+        if (pthread_create(&rxWorkerTid[i], NULL, esalRxWorker, NULL)) {
+            SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                SWERR_FILELINE, "pthread_create fail in esalHostRxPoolStart\n"));
+            std::cout << "ERROR esalHostRxPoolStart fail\n";
+            rxPoolLeave = true;
+            while (i--) {
+                pthread_join(rxWorkerTid[i], NULL);
+            }
+            return false;
+        }
+        std::string name = "ESALRx" + std::to_string(i);
+        (void) pthread_setname_np(rxWorkerTid[i], name.c_str());
+    }
+    rxPoolRunning = true;
+    return true;
+}
+
+void esalHostRxPoolStop(void) {
+    if (!rxPoolRunning) {
+        return;
+    }
+    rxPoolLeave = true;
+    for (uint32_t i = 0; i < rxWorkerCount; i++) {
+        pthread_join(rxWorkerTid[i], NULL);
+    }
+    rxPoolRunning = false;
+
+    // Nothing else consumes now, so deliver whatever is left behind.
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    for (auto &ring : rxQueues) {
+        while (!ring.slots.empty() && rxQueueDrain(ring)) {}
+    }
+}
+
+// Takes a free ring for a new filter.  Caller holds filterTableMutex.
+static int rxQueueAlloc(const std::string &filterName, int priority) {
+    if (!rxWorkerCount) {
+        return -1;
+    }
+    for (int q = 0; q < MAX_FILTER_TABLE_SIZE; q++) {
+        RxRing &ring = rxQueues[q];
+        if (ring.inUse) {
+            continue;
+        }
+        if (ring.slots.empty()) {
+            rxRingInit(ring, rxQueueDepth);
+        } else {
+            // Leftovers drain in place, only the counters start over.
+            ring.enqueued.store(0);
+            ring.overflows.store(0);
+            ring.batches.store(0);
+            ring.highWater.store(0);
+            ring.delivered.store(0);
+            ring.latencySumUsec.store(0);
+            ring.latencyMaxUsec.store(0);
+        }
+        ring.filterName = filterName;
+        ring.priority = priority;
+        ring.inUse = true;
+        return q;
+    }
+    return -1;
+}
+
+bool esalHostRxQueueStats(std::string &report) {
+    std::stringstream ss;
+    ss << "rxWorkerThreads=" << rxWorkerCount
+       << " rxQueueDepth=" << rxQueueDepth
+       << " running=" << rxPoolRunning << std::endl;
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    for (int q = 0; q < MAX_FILTER_TABLE_SIZE; q++) {
+        RxRing *ring = &rxQueues[q];
+        if (!ring->inUse) {
+            continue;
+        }
+        uint64_t delivered = ring->delivered.load(std::memory_order_relaxed);
+        ss << "queue=" << q
+           << " filter=" << ring->filterName
+           << " prio=" << ring->priority
+           << " depth=" << (ring->head.load() - ring->tail.load())
+           << " highWater=" << ring->highWater.load(std::memory_order_relaxed)
+           << " enqueued=" << ring->enqueued.load(std::memory_order_relaxed)
+           << " drops=" << ring->overflows.load(std::memory_order_relaxed)
+           << " delivered=" << delivered
+           << " avgLatencyUsec=" << (delivered ?
+                ring->latencySumUsec.load(std::memory_order_relaxed) / delivered : 0)
+           << " maxLatencyUsec=" << ring->latencyMaxUsec.load(std::memory_order_relaxed)
+           << std::endl;
+    }
+    if (rxBatchRunning) {
+        ss << "batchRing enqueued=" << rxBatchRing.enqueued.load()
+           << " drops=" << rxBatchRing.overflows.load()
+           << " batches=" << rxBatchRing.batches.load() << std::endl;
+    }
+    report = ss.str();
+    return true;
+}
 
-    bool has_macmask() { return false; };
+static void *esalRxBatchWorker(void*) {
+    // Poll at a fraction of the time bound so a batch is not held much
+    // past it.
+    useconds_t idleUsec = rxBatchMaxUsec / 4;
+    if (idleUsec < 50) idleUsec = 50;
+    if (idleUsec > 1000) idleUsec = 1000;
+    while (!rxBatchLeave.load(std::memory_order_relaxed)) {
+        if (!rxBatchFlush(false)) {
+            usleep(idleUsec);
+        }
+    }
+    pthread_exit(NULL);
+    return 0;
+}
 
-    bool has_vlan() { return false; };
+void esalHostRxBatchConfig(uint32_t maxPkts, uint32_t maxUsec) {
+    if (rxBatchRunning) {
+        return;
+    }
+    if (!maxPkts) maxPkts = RX_BATCH_DEFAULT_PKTS;
+    if (maxPkts > RX_BATCH_MAX_PKTS) maxPkts = RX_BATCH_MAX_PKTS;
+    rxBatchMaxPkts = maxPkts;
+    rxBatchMaxUsec = maxUsec;
+    std::cout << "Rx Batch maxPkts: " << rxBatchMaxPkts
+              << " maxUsec: " << rxBatchMaxUsec << "\n" << std::flush;
+}
 
-    bool has_vlanmask() { return false; };
+void esalHostRxBatchStop(void) {
+    if (!rxBatchRunning) {
+        return;
+    }
+    rxBatchLeave = true;
+    pthread_join(rxBatchTid, NULL);
+    rxBatchRunning = false;
 
-    uint16_t vlan() { return 100; };
+    // Nothing else consumes now, so deliver whatever is left behind.
+    while (rxBatchFlush(true)) {}
+}
 
-    uint16_t vlanmask() { return 0xff; } ;
+bool esalHostRxBatchStats(uint64_t *enqueued, uint64_t *overflows,
+                          uint64_t *batches) {
+    if (!enqueued || !overflows || !batches) {
+        return false;
+    }
+    *enqueued = rxBatchRing.enqueued.load(std::memory_order_relaxed);
+    *overflows = rxBatchRing.overflows.load(std::memory_order_relaxed);
+    *batches = rxBatchRing.batches.load(std::memory_order_relaxed);
+    return true;
+}
 
-    int vendorport_size() { return 1; };
-    uint32_t vendorport(int) { return 28; };
-    
-    RawData rawData;
+// PACKET CAPTURE:
+// Rx and Tx packets can be copied into a pcapng file mapped into memory,
+// so a capture survives the process and can be copied off the card and
+// opened as is.  The file is a section header and one Ethernet interface,
+// then a fixed number of fixed size slots, each one complete block.  A
+// packet claims the next slot and overwrites it, so capture never
+// allocates.  A slot is an Enhanced Packet Block whose comment carries the
+// ingress or egress port and the matched filter, padded out to the slot
+// size; a slot not yet written is an Interface Statistics Block.  Once the
+// ring wraps the packets are out of time order, which readers accept
+// (reordercap puts them back).
+//
+// The ring and the capture filter are published like the filter table
+// snapshot, and a packet with capture off pays one atomic load.
+const uint32_t CAPTURE_DEFAULT_SLOTS = 4096;
+const uint32_t CAPTURE_MAX_SLOTS = 262144;
+const uint32_t CAPTURE_DEFAULT_SNAPLEN = 256;
+const uint32_t CAPTURE_MAX_SNAPLEN = 9216;
+const uint32_t CAPTURE_COMMENT_BYTES = 64;
+const char *CAPTURE_DEFAULT_PATH = "/tmp/esalCapture.pcapng";
+
+const uint8_t CAPTURE_RX = 1;
+const uint8_t CAPTURE_TX = 2;
+
+// pcapng block and option layout.
+const uint32_t PCAPNG_SHB = 0x0A0D0D0A;
+const uint32_t PCAPNG_IDB = 1;
+const uint32_t PCAPNG_ISB = 5;
+const uint32_t PCAPNG_EPB = 6;
+const uint32_t PCAPNG_MAGIC = 0x1A2B3C4D;
+const uint16_t PCAPNG_OPT_END = 0;
+const uint16_t PCAPNG_OPT_COMMENT = 1;
+const uint16_t PCAPNG_OPT_EPB_FLAGS = 2;
+const uint16_t PCAPNG_LINKTYPE_ETHERNET = 1;
+const uint32_t PCAPNG_SHB_LEN = 28;
+const uint32_t PCAPNG_IDB_LEN = 20;
+const uint32_t PCAPNG_EPB_FIXED = 28 + 8 + 4 + 4 + 4;  // less data and comment
+const uint32_t PCAPNG_ISB_FIXED = 20 + 4 + 4 + 4;      // less comment
+
+struct CaptureRing {
+    uint8_t *base;
+    size_t size;
+    int fd;
+    uint32_t slots;
+    uint32_t slotSize;
+    uint32_t snapLen;
+    std::string path;
+    std::atomic<uint64_t> next;
+    std::atomic<uint64_t> captured;
+};
 
-    int rawdata_size() { return 5;} //rawdata_array.size(); };
-    RawData rawdata(int index) { return rawData(index); };
+struct CaptureFilter {
+    uint8_t dirMask;
+    int32_t lPort;
+    std::string filterName;
+    FilterProgram prog;
+    bool hasProg;
 };
-// filter.rawdata(i).offset();
 
-#endif
+static std::atomic<CaptureRing*> captureRing(nullptr);
+static std::atomic<CaptureFilter*> captureFilter(nullptr);
 
-struct FilterEntry{
-    std::string filterName; 
-    EsalL2Filter filter; 
-    unsigned char mac[MAC_SIZE];
-    unsigned char macMask[MAC_SIZE];
-    bool pendingDelete; 
-    sai_object_id_t aclEntryOid;
-    sai_object_id_t aclEntryV6Oid;
+static inline uint32_t capturePad4(uint32_t len) {
+    return (len + 3) & ~3u;
+}
 
-};
+static inline void captureWord(uint8_t *&p, uint32_t val) {
+    memcpy(p, &val, sizeof(val));
+    p += sizeof(val);
+}
 
-const int MAX_FILTER_TABLE_SIZE = 32;
-static FilterEntry filterTable[MAX_FILTER_TABLE_SIZE];
-static int filterTableSize = 0;
-static std::mutex filterTableMutex;
-static VendorRxCallback_fp_t rcvrCb;
-static void *rcvrCbId;
-sai_object_id_t hostInterface;
+static inline void captureOption(uint8_t *&p, uint16_t code, uint16_t len) {
+    memcpy(p, &code, sizeof(code));
+    memcpy(p + sizeof(code), &len, sizeof(len));
+    p += sizeof(code) + sizeof(len);
+}
 
+// Comment of exactly len bytes, the text padded with blanks.
+static void captureComment(uint8_t *&p, const char *text, uint32_t len) {
+    captureOption(p, PCAPNG_OPT_COMMENT, len);
+    size_t textLen = strnlen(text, len);
+    memcpy(p, text, textLen);
+    memset(p + textLen, ' ', len - textLen);
+    p += len;
+}
 
+static void captureEmptySlot(uint8_t *slot, uint32_t slotSize) {
+    uint8_t *p = slot;
+    captureWord(p, PCAPNG_ISB);
+    captureWord(p, slotSize);
+    captureWord(p, 0);
+    captureWord(p, 0);
+    captureWord(p, 0);
+    captureComment(p, "unused", slotSize - PCAPNG_ISB_FIXED);
+    captureOption(p, PCAPNG_OPT_END, 0);
+    captureWord(p, slotSize);
+}
 
-static void convertMacStringToAddr(std::string &macString,
-                                   unsigned char *macAddr) {
-    int macIdx = 0;
-    memset(macAddr, 0, MAC_SIZE);
-    for(auto ch : macString) {
-        unsigned char num = 0; 
-        switch (ch) {
-            case ':':
-                macIdx++;
-                break;
-            case 'A':
-            case 'a':
-                num = 10;
-                break;
-            case 'B':
-            case 'b':
-                num = 11;
-                break;
-            case 'C':
-            case 'c':
-                num = 12;
-                break;
-            case 'D':
-            case 'd':
-                num = 13;
-                break;
-            case 'E':
-            case 'e':
-                num = 14;
-                break;
-            case 'F':
-            case 'f':
-                num = 15;
-                break;
-            default:
-                if (ch >= '0' && ch <= '9') {
-                   num = ch - '0';
-                }
-        }
-        if (macIdx <  MAC_SIZE) {
-            macAddr[macIdx] = (macAddr[macIdx]*16) + num;
-        }
+static void captureRecord(uint8_t dir, uint32_t lPort, const char *filterName,
+                          const void *buf, uint32_t len) {
+    if (!captureRing.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    uint32_t slot = filterReadLock();
+    CaptureRing *ring = captureRing.load(std::memory_order_acquire);
+    const CaptureFilter *filter = captureFilter.load(std::memory_order_acquire);
+    if (!ring ||
+        (filter && (!(filter->dirMask & dir) ||
+                    ((filter->lPort >= 0) && ((uint32_t) filter->lPort != lPort)) ||
+                    (!filter->filterName.empty() &&
+                     (filter->filterName != filterName)) ||
+                    (filter->hasProg &&
+                     !filterProgramRun(filter->prog,
+                                       (const unsigned char*) buf, len))))) {
+        filterReadUnlock(slot);
+        return;
     }
+
+    uint64_t seq = ring->next.fetch_add(1, std::memory_order_relaxed);
+    uint8_t *p = ring->base + PCAPNG_SHB_LEN + PCAPNG_IDB_LEN +
+                 ((seq % ring->slots) * ring->slotSize);
+    uint32_t capLen = (len < ring->snapLen) ? len : ring->snapLen;
+    uint32_t dataLen = capturePad4(capLen);
+    uint64_t usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+    char comment[CAPTURE_COMMENT_BYTES];
+    snprintf(comment, sizeof(comment), "%s port=%u filter=%s",
+             (dir == CAPTURE_RX) ? "rx" : "tx", lPort,
+             (filterName && *filterName) ? filterName : "-");
+
+    captureWord(p, PCAPNG_EPB);
+    captureWord(p, ring->slotSize);
+    captureWord(p, 0);
+    captureWord(p, usec >> 32);
+    captureWord(p, usec & 0xffffffff);
+    captureWord(p, capLen);
+    captureWord(p, len);
+    memcpy(p, buf, capLen);
+    memset(p + capLen, 0, dataLen - capLen);
+    p += dataLen;
+    captureOption(p, PCAPNG_OPT_EPB_FLAGS, 4);
+    captureWord(p, (dir == CAPTURE_RX) ? 1 : 2);
+    captureComment(p, comment, ring->slotSize - PCAPNG_EPB_FIXED - dataLen);
+    captureOption(p, PCAPNG_OPT_END, 0);
+    captureWord(p, ring->slotSize);
+    ring->captured.fetch_add(1, std::memory_order_relaxed);
+
+    filterReadUnlock(slot);
 }
 
-static bool searchFilterTable(
-    uint32_t lPort, int &idx, const void *buffer, sai_size_t bufferSz) {
-    const unsigned char *bufPtr = (const unsigned char*) buffer;
-    unsigned char macAddr[MAC_SIZE];
- 
-    // Check to see that the buffer is bigger than minimum size
-    if (bufferSz < ((2*MAC_SIZE)+2+2)) {
+bool esalHostCaptureStart(uint32_t slots, uint32_t snapLen,
+                          const std::string &path) {
+    if (!slots) slots = CAPTURE_DEFAULT_SLOTS;
+    if (slots > CAPTURE_MAX_SLOTS) slots = CAPTURE_MAX_SLOTS;
+    if (!snapLen) snapLen = CAPTURE_DEFAULT_SNAPLEN;
+    if (snapLen > CAPTURE_MAX_SNAPLEN) snapLen = CAPTURE_MAX_SNAPLEN;
+    std::string file = path.empty() ? CAPTURE_DEFAULT_PATH : path;
+
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    if (captureRing.load()) {
         return false;
     }
 
-    // Buffer is packet with the following format:
-    //    
-    //    DST MAC: 6 bytes
-    //    SRC MAC: 6 bytes
-    //    VLAN Type: 2 bytes ... must be 0x8100
-    //    VLAN ID: 2 bytes
-    //    Ether Type for packet : 2 bytes
-
-    // Assuming packet starts at DST MAC.
-    //     DSTMAC[6] SRCMAC[6] ETYPE[2] VLANID[2]
-   
-    memcpy(macAddr, buffer, MAC_SIZE);
- 
-    // Get VLAN. 
-    uint16_t vlan = 0;
-    unsigned char *vlanPtr = (unsigned char*) &vlan; 
-    if ((bufPtr[12] == 0x81) && (bufPtr[13] == 0x00)) {
-        vlanPtr[0] = bufPtr[14];
-        vlanPtr[1] = bufPtr[15];
-        vlan = ntohs(vlan);
-        vlan &= 0xfff; 
+    uint32_t slotSize = PCAPNG_EPB_FIXED + capturePad4(snapLen) +
+                        CAPTURE_COMMENT_BYTES;
+    size_t size = PCAPNG_SHB_LEN + PCAPNG_IDB_LEN + ((size_t) slots * slotSize);
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "open fail in esalHostCaptureStart\n"));
+        std::cout << "esalHostCaptureStart open fail: " << file << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, size)) {
+        close(fd);
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "ftruncate fail in esalHostCaptureStart\n"));
+        return false;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "mmap fail in esalHostCaptureStart\n"));
+        return false;
     }
 
-    // Search table.
-    for(int i = 0; i < filterTableSize; i++) {
-        bool matching = true; 
-        EsalL2Filter &fltr = filterTable[i].filter;
-  
-        // Ignore if marked pending delete. 
-        if (filterTable[i].pendingDelete) continue; 
+    // Section header, of unknown length, and the one interface.
+    uint8_t *p = (uint8_t*) base;
+    int64_t sectionLen = -1;
+    uint16_t version[2] = {1, 0};
+    captureWord(p, PCAPNG_SHB);
+    captureWord(p, PCAPNG_SHB_LEN);
+    captureWord(p, PCAPNG_MAGIC);
+    memcpy(p, version, sizeof(version));
+    p += sizeof(version);
+    memcpy(p, &sectionLen, sizeof(sectionLen));
+    p += sizeof(sectionLen);
+    captureWord(p, PCAPNG_SHB_LEN);
+
+    uint16_t linkType[2] = {PCAPNG_LINKTYPE_ETHERNET, 0};
+    captureWord(p, PCAPNG_IDB);
+    captureWord(p, PCAPNG_IDB_LEN);
+    memcpy(p, linkType, sizeof(linkType));
+    p += sizeof(linkType);
+    captureWord(p, snapLen);
+    captureWord(p, PCAPNG_IDB_LEN);
+
+    for (uint32_t i = 0; i < slots; i++) {
+        captureEmptySlot(p + ((size_t) i * slotSize), slotSize);
+    }
 
-        // Check to see if logical port matches.
-        auto vpsize = fltr.vendorport_size(); 
-        if (vpsize) {
-            matching = false;
-            for(int vpidx = 0; vpidx < vpsize; vpidx++) {
-                if (fltr.vendorport(vpidx) == lPort) {
-                    matching = true;
-                    break; 
-                }
-            }
-            if (!matching) continue; 
-        }
+    CaptureRing *ring = new CaptureRing();
+    ring->base = (uint8_t*) base;
+    ring->size = size;
+    ring->fd = fd;
+    ring->slots = slots;
+    ring->slotSize = slotSize;
+    ring->snapLen = snapLen;
+    ring->path = file;
+    ring->next = 0;
+    ring->captured = 0;
+    captureRing.store(ring, std::memory_order_release);
+    std::cout << "Capture started: " << file << " slots: " << slots
+              << " snapLen: " << snapLen << "\n" << std::flush;
+    return true;
+}
 
-        // VLAN present.
-        if (fltr.has_vlan()) {
-            uint16_t vlanMask =  0xfff;
-            if (fltr.has_vlanmask()) {
-                vlanMask = fltr.vlanmask();
-            }
+void esalHostCaptureStop(void) {
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    CaptureRing *ring = captureRing.exchange(nullptr);
+    if (!ring) {
+        return;
+    }
+    filterSynchronize();
+    msync(ring->base, ring->size, MS_ASYNC);
+    munmap(ring->base, ring->size);
+    close(ring->fd);
+    delete ring;
+}
 
-            if ((vlan & vlanMask) != (fltr.vlan() & vlanMask)) {
-                matching = false;
-            }
+// Filter terms, all of which must hold: rx or tx, port=<lPort>,
+// filter=<name>, and raw data as offset:data[:mask], numbers in C syntax.
+// No terms captures everything.
+bool esalHostCaptureFilter(const std::string &spec) {
+    CaptureFilter *filter = nullptr;
+    std::stringstream ss(spec);
+    std::string term;
+    CompiledRawData fields[MAX_FILTER_RAW_DATA];
+    int count = 0;
+    bool ok = true;
+    while (ok && (ss >> term)) {
+        if (!filter) {
+            filter = new CaptureFilter();
+            filter->dirMask = 0;
+            filter->lPort = -1;
+            filter->hasProg = false;
         }
-#ifndef UTS
-        // Check MAC. 
-        //
-        if (fltr.has_mac() && matching) {
-            unsigned char macMatch[MAC_SIZE];
-            memcpy(macMatch, filterTable[i].mac, MAC_SIZE);
-            unsigned char macMask[MAC_SIZE] = {0xff, 0xff, 0xff,
-                                               0xff, 0xff, 0xff};
-            if (fltr.has_macmask()) {
-                memcpy(macMask, filterTable[i].macMask, MAC_SIZE);
-            }
-            for (int i = 0; i < MAC_SIZE; i++) {
-                if ((macMatch[i] & macMask[i]) != (macAddr[i] & macMask[i])) {
-                    matching = false;
-                    break;
+        try {
+            if (term == "rx") {
+                filter->dirMask |= CAPTURE_RX;
+            } else if (term == "tx") {
+                filter->dirMask |= CAPTURE_TX;
+            } else if (term.compare(0, 5, "port=") == 0) {
+                filter->lPort = std::stoi(term.substr(5));
+            } else if (term.compare(0, 7, "filter=") == 0) {
+                filter->filterName = term.substr(7);
+            } else if (count < MAX_FILTER_RAW_DATA) {
+                CompiledRawData &raw = fields[count++];
+                size_t first = term.find(':');
+                size_t second = term.find(':', first + 1);
+                ok = (first != std::string::npos);
+                raw.offset = std::stoul(term.substr(0, first), nullptr, 0);
+                raw.data = std::stoul(term.substr(first + 1, second - first - 1),
+                                      nullptr, 0);
+                if (second == std::string::npos) {
+                    // Without a mask the width follows the data.
+                    raw.mask = (raw.data > 0xffff) ? 0xffffffff :
+                               (raw.data > 0xff) ? 0xffff : 0xff;
+                } else {
+                    raw.mask = std::stoul(term.substr(second + 1), nullptr, 0);
                 }
+                raw.width = (raw.mask & 0xffff0000) ? 4 :
+                            (raw.mask & 0xff00) ? 2 : 1;
+            } else {
+                ok = false;
             }
+        } catch (...) {
+            ok = false;
         }
-#ifndef LARCH_ENVIRON
-        // Check Raw Data
-        if (fltr.rawdata_size() && matching) {
-            for (auto i = 0; i < fltr.rawdata_size(); i++){
-                unsigned const char *bufPtr = (unsigned const char*) buffer;
-                auto offset = fltr.rawdata(i).offset(); 
-                if ((offset*sizeof(long))  > bufferSz) {
-                    matching = false; 
-                    break; 
-                }
-                auto data = fltr.rawdata(i).data(); 
-                auto mask = fltr.rawdata(i).mask(); 
-                unsigned const char *pktPtr = bufPtr+offset;
-
-                // Coerce to longword alignment.
-                // Assuming mask handles bufsize that
-                // is not multiple of 4 length. 
-                unsigned long pkt =
-                    (pktPtr[offset] << 24) | (pktPtr[offset+1] << 16) | 
-                    (pktPtr[offset+2] << 8) | (pktPtr[offset+3]);
-
-                pkt = ntohl(pkt);
-                
-                // Compare the packet contents masked with the raw data masked. 
-                //  
-                if ((pkt & mask) != (data & mask)) {
-                    matching = false;
-                    break;
-                }
-            }
+    }
+    if (ok && filter) {
+        if (!filter->dirMask) {
+            filter->dirMask = CAPTURE_RX | CAPTURE_TX;
         }
-#endif
-#endif
-        if (matching) {
-            idx = i;
-            return true;
+        if (count) {
+            filter->hasProg = true;
+            ok = compileRawDataProgram(filter->prog, fields, count);
         }
     }
+    if (!ok) {
+        delete filter;
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    CaptureFilter *old = captureFilter.exchange(filter);
+    filterSynchronize();
+    delete old;
+    return true;
+}
 
-    return false;
+bool esalHostCaptureStats(std::string &report) {
+    std::stringstream ss;
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    CaptureRing *ring = captureRing.load();
+    if (!ring) {
+        ss << "capture off" << std::endl;
+    } else {
+        uint64_t next = ring->next.load(std::memory_order_relaxed);
+        ss << "capture on file=" << ring->path
+           << " slots=" << ring->slots << " snapLen=" << ring->snapLen
+           << " captured=" << ring->captured.load(std::memory_order_relaxed)
+           << " overwritten=" << ((next > ring->slots) ? next - ring->slots : 0)
+           << std::endl;
+    }
+    report = ss.str();
+    return ring != nullptr;
 }
 
 bool esalHandleSaiHostRxPacket(const void *buffer,
@@ -319,9 +2031,10 @@ bool esalHandleSaiHostRxPacket(const void *buffer,
                                const sai_attribute_t *attrList) {
 
     // Check to see if callback is registered yet. 
-    if (!rcvrCb) {
+    if (!rcvrCb && !rcvrBatchCb) {
         return false;
     } 
+    RxLatencyTimer rxTimer;
 
     // Find the incoming port.
     sai_object_id_t portSai = SAI_NULL_OBJECT_ID;
@@ -340,28 +2053,55 @@ bool esalHandleSaiHostRxPacket(const void *buffer,
         return false;
     }
 
-    // Convert from SAI to Port Id.
-    uint16_t portId = 0;
-    if (!esalPortTableFindId(portSai, &portId)) {
+    // Convert to logical port and search the filter table for this port.
+    // The name is copied out of the snapshot, so the callback can take its
+    // time.
+    RxMatch rxMatch = {MAX_CLASSIFIER_PORTS, -1, -1};
+    static thread_local std::string fname;
+    RxStatShard &stats = rxStatShard();
+    if (!searchFilterTable(portSai, rxMatch, fname, buffer, bufferSz)) {
+        captureRecord(CAPTURE_RX, rxMatch.lPort, "", buffer, bufferSz);
+        uint32_t missRow = (rxMatch.lPort < MAX_CLASSIFIER_PORTS) ?
+                            rxMatch.lPort : MAX_CLASSIFIER_PORTS;
+        stats.misses[missRow].fetch_add(1, std::memory_order_relaxed);
         return false;
     }
+    uint32_t lPort = rxMatch.lPort;
+    if (rxMatch.rxFilterSlot >= 0) {
+        stats.hits[rxMatch.rxFilterSlot].fetch_add(1, std::memory_order_relaxed);
+        stats.bytes[rxMatch.rxFilterSlot].fetch_add(bufferSz,
+                                                   std::memory_order_relaxed);
+    }
+    captureRecord(CAPTURE_RX, lPort, fname.c_str(), buffer, bufferSz);
 
-    // Convert to logical port. 
-    uint32_t lPort;
-    if (!saiUtils.GetLogicalPort(0, portId, &lPort)) {
+    // Police the port, then the filter.
+    uint64_t nowNsec = rxTimer.startNsec;
+    if ((lPort < MAX_CLASSIFIER_PORTS) &&
+        !rxPolicerAllow(rxPortPolicers[lPort], nowNsec)) {
+        return false;
+    }
+    if ((rxMatch.rxFilterSlot >= 0) &&
+        !rxPolicerAllow(rxFilterSlots[rxMatch.rxFilterSlot].policer, nowNsec)) {
         return false;
     }
 
-    // Search the filter table for this port. 
-    const char *fname = 0;
-    int idx;
-    if (searchFilterTable(lPort, idx, buffer, bufferSz)) {
-        fname = filterTable[idx].filterName.c_str();
-    } else {
+    int rxQueue = rxMatch.rxQueue;
+    if (rxPoolRunning && (rxQueue >= 0)) {
+        return rxRingPush(rxQueues[rxQueue], fname, lPort, buffer, bufferSz);
+    }
+    if (rxBatchRunning) {
+        return rxRingPush(rxBatchRing, fname, lPort, buffer, bufferSz);
+    }
+    if (!rcvrCb) {
         return false;
     }
 
-    return rcvrCb(rcvrCbId, fname, lPort,
+    // Only the Rx workers can be delivering alongside this thread.
+    std::unique_lock<std::mutex> lock(rxDeliverMutex, std::defer_lock);
+    if (rxPoolRunning) {
+        lock.lock();
+    }
+    return rcvrCb(rcvrCbId, fname.c_str(), lPort,
                   (uint16_t) bufferSz, (void*) buffer);
 }
 
@@ -376,6 +2116,121 @@ int VendorRegisterRxCb(VendorRxCallback_fp_t cb, void *cbId) {
     return ESAL_RC_OK;
 }
 
+int VendorRegisterRxBatchCb(VendorRxBatchCallback_fp_t cb, void *cbId) {
+    std::cout << __PRETTY_FUNCTION__ << std::endl;
+    if (!useSaiFlag){
+        return ESAL_RC_OK;
+    }
+    if (rxBatchRunning) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "already registered in VendorRegisterRxBatchCb\n"));
+        return ESAL_RC_FAIL;
+    }
+    if (!cb) {
+        return ESAL_RC_FAIL;
+    }
+
+    // The worker pool delivers batches itself.
+    if (rxWorkerCount) {
+        rcvrBatchCbId = cbId;
+        rcvrBatchCb = cb;
+        return ESAL_RC_OK;
+    }
+
+    rxRingInit(rxBatchRing, RX_BATCH_RING_DEPTH);
+    rcvrBatchCbId = cbId;
+    rcvrBatchCb = cb;
+    rxBatchLeave = false;
+
+    if (pthread_create(&rxBatchTid, NULL, esalRxBatchWorker, NULL)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "pthread_create fail in VendorRegisterRxBatchCb\n"));
+        std::cout << "ERROR VendorRegisterRxBatchCb fail\n";
+        return ESAL_RC_FAIL;
+    }
+    (void) pthread_setname_np(rxBatchTid, "ESALRxBatch");
+    rxBatchRunning = true;
+    return ESAL_RC_OK;
+}
+
+// Finds a raw data field that pins the whole of offset..offset+width.
+static const CompiledRawData *rawDataPinned(const CompiledRawData *fields,
+                                            int count, uint32_t offset,
+                                            uint32_t width) {
+    uint32_t full = (width == 4) ? 0xffffffff : ((1u << (8 * width)) - 1);
+    for (int r = 0; r < count; r++) {
+        if ((fields[r].offset == offset) && (fields[r].width == width) &&
+            ((fields[r].mask & full) == full)) {
+            return &fields[r];
+        }
+    }
+    return nullptr;
+}
+
+// Offloads raw data onto the ACL fields the packet filter tables carry.
+// A field only means what its offset suggests once the fields before it
+// are pinned, e.g. offset 40 is the UDP destination port only in a single
+// tagged IPv4 UDP frame, so a field is enabled only when the filter pins
+// its layout.  Everything else, QinQ inner tags, ICMP types and the like,
+// is left to the software match.
+static void mapRawDataToAcl(const CompiledRawData *fields, int count,
+                            aclEntryAttributes &acl, bool &isDhcp) {
+    const CompiledRawData *tpid =
+        rawDataPinned(fields, count, VLAN_ETHERTYPE_OFFSET, 2);
+    bool tagged = tpid && ((tpid->data == 0x8100) || (tpid->data == 0x88a8));
+    bool singleTagged = tpid && (tpid->data == 0x8100);
+
+    const CompiledRawData *etype =
+        singleTagged ? rawDataPinned(fields, count, ETHERTYPE_OFFSET, 2) :
+                       nullptr;
+    bool ipv4 = etype && (etype->data == 0x800);
+    bool ipv6 = etype && (etype->data == 0x86dd);
+
+    const CompiledRawData *proto = nullptr;
+    if (ipv4) {
+        proto = rawDataPinned(fields, count, IPV4_PROTO_FIELD_OFFSET, 1);
+    } else if (ipv6) {
+        proto = rawDataPinned(fields, count, IPV6_NEXT_HDR_OFFSET, 1);
+    }
+    bool l4 = proto && ((proto->data == 6) || (proto->data == 17));
+    uint32_t l4Offset = ipv4 ? IPV4_L4_SRC_PORT_OFFSET : IPV6_L4_SRC_PORT_OFFSET;
+
+    bool vlanDhcp = false;
+    bool portDhcp = false;
+    for (int r = 0; r < count; r++) {
+        const CompiledRawData &raw = fields[r];
+        sai_acl_field_data_t *field = nullptr;
+        if (tagged && (raw.offset == VLAN_ID_OFFSET) && (raw.width == 2)) {
+            field = &acl.field_outer_vlan_id;
+            field->data.u16 = raw.data & 0xfff;
+            field->mask.u16 = raw.mask & 0xfff;
+            vlanDhcp = (raw.data == 2003);
+        } else if (singleTagged && (raw.offset == ETHERTYPE_OFFSET) &&
+                   (raw.width == 2)) {
+            field = &acl.field_ether_type;
+            field->data.u16 = raw.data;
+            field->mask.u16 = raw.mask;
+        } else if (proto && (&raw == proto)) {
+            field = &acl.field_ip_protocol;
+            field->data.u8 = raw.data;
+            field->mask.u8 = raw.mask;
+        } else if (l4 && (raw.width == 2) &&
+                   ((raw.offset == l4Offset) || (raw.offset == l4Offset + 2))) {
+            field = (raw.offset == l4Offset) ? &acl.field_l4_src_port :
+                                               &acl.field_l4_dst_port;
+            field->data.u16 = raw.data;
+            field->mask.u16 = raw.mask;
+            portDhcp = portDhcp || ((raw.offset == UDP_DST_PORT_OFFSET) &&
+                                    ((raw.data == 67) || (raw.data == 68)));
+        }
+        if (field) {
+            field->enable = true;
+        }
+    }
+
+    isDhcp = ipv4 && proto && (proto->data == 17) && vlanDhcp && portDhcp;
+}
+
 int VendorAddPacketFilter(const char *buf, uint16_t length) {
     std::cout << "VendorAddPacketFilter:" << std::endl;
     if (!useSaiFlag){
@@ -384,23 +2239,19 @@ int VendorAddPacketFilter(const char *buf, uint16_t length) {
 
     uint16_t vlan = 0;
     bool matching = false;
+    bool isDhcp = false;
     uint32_t dev;
     uint32_t lPort;
     uint32_t pPort;
     std::vector<sai_object_id_t> port_list;
-    uint16_t VlanTagEtherType;
-    uint16_t VlanId;
-    uint16_t EtherType;
-    uint8_t IPv4Proto;
-    uint16_t UdpDstPort;
 
     std::unique_lock<std::mutex> lock(filterTableMutex);
 
     // Make sure filter table is not exhausted.
-    if (filterTableSize >= MAX_FILTER_TABLE_SIZE) {
+    if (filterTable.size() >= MAX_FILTER_TABLE_SIZE) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "table exhausted in VendorAddPacketFilter\n"));
-        std::cout << "Packet Filter Table Exhausted: " << filterTableSize
+        std::cout << "Packet Filter Table Exhausted: " << filterTable.size()
                   << std::endl;
         return ESAL_RC_FAIL; 
     }
@@ -418,14 +2269,15 @@ int VendorAddPacketFilter(const char *buf, uint16_t length) {
     // Check to see if insert the same filter name, key into the filter 
     // table. 
     std::string filterName = filter.filtername();
-    for (int i = 0; i < filterTableSize; i++) {
-        if (filterTable[i].filterName == filterName) {
+    for (auto &entry : filterTable) {
+        if (entry.filterName == filterName) {
             return ESAL_RC_OK;
         }
     }
 
-    // Add in the shadow.
-    FilterEntry *newEntry = filterTable+filterTableSize;
+    // Build the entry aside, it is appended once the ACLs are in.
+    FilterEntry entry;
+    FilterEntry *newEntry = &entry;
     newEntry->pendingDelete = false;
     newEntry->filterName = filterName;
     newEntry->filter = filter;
@@ -465,58 +2317,18 @@ int VendorAddPacketFilter(const char *buf, uint16_t length) {
         aclEntryAttr.field_outer_vlan_id.mask.u16 = vlanMask;
     }
 
-    if (filter.rawdata_size()) {
-        for (auto i = 0; i < filter.rawdata_size(); i++) {
-            auto offset = filter.rawdata(i).offset();
-            auto data = filter.rawdata(i).data();
-            auto mask = filter.rawdata(i).mask(); 
-            switch (offset) {
-                case VLAN_ETHERTYPE_OFFSET: 
-                    VlanTagEtherType = data;
-                break;
-                
-                case VLAN_ID_OFFSET: 
-                    aclEntryAttr.field_outer_vlan_id.data.u16 = data;
-                    aclEntryAttr.field_outer_vlan_id.mask.u16 = mask;
-                    VlanId = data;
-                break;
-                
-                case ETHERTYPE_OFFSET: 
-                    aclEntryAttr.field_ether_type.data.u16 = data;
-                    aclEntryAttr.field_ether_type.mask.u16 = mask;
-                    EtherType = data;
-                break;
-                
-                case IPV4_PROTO_OFFSET: 
-                    aclEntryAttr.field_ip_protocol.data.u8 = data;
-                    aclEntryAttr.field_ip_protocol.mask.u8 = mask;
-                    IPv4Proto = data;
-                break;
-                
-                case UDP_DST_PORT_OFFSET: 
-                    aclEntryAttr.field_l4_dst_port.data.u16 = data;
-                    aclEntryAttr.field_l4_dst_port.mask.u16 = mask;
-                    UdpDstPort = data;
-                break;
-
-                default:
-                    break;
-            }
-        }
-
-        // Check if it`s DHCP filter
-
-        if (VlanTagEtherType == 0x8100 &&
-            VlanId == 2003 &&
-            EtherType == 0x800 &&
-            IPv4Proto == 17 &&
-            (UdpDstPort == 67 || UdpDstPort == 68)) {
-                aclEntryAttr.field_outer_vlan_id.enable = true;
-                aclEntryAttr.field_ether_type.enable = true;
-                aclEntryAttr.field_ip_protocol.enable = true;
-                aclEntryAttr.field_l4_dst_port.enable = true;
-        }
+    // Raw data goes to the ACL where it maps onto a field, and is always
+    // checked again in software.
+    CompiledRawData fields[MAX_FILTER_RAW_DATA];
+    int rawSize = decodeRawData(filter, fields);
+    if (rawSize < 0) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "too much raw data in VendorAddPacketFilter\n"));
+        std::cout << "Packet Filter raw data exceeds " << MAX_FILTER_RAW_DATA
+                  << ": " << filterName << std::endl;
+        return ESAL_RC_FAIL;
     }
+    mapRawDataToAcl(fields, rawSize, aclEntryAttr, isDhcp);
 
     // Check to see if logical port matches.
     auto vpsize = filter.vendorport_size();
@@ -580,7 +2392,21 @@ int VendorAddPacketFilter(const char *buf, uint16_t length) {
     newEntry->aclEntryOid = aclEntryOid;
     newEntry->aclEntryV6Oid = aclEntryV6Oid;
     
-    filterTableSize++;
+    // Rx worker pool priority, see RX WORKER POOL.
+    const unsigned char linkLocalMac[] = {0x01, 0x80, 0xC2, 0x00, 0x00};
+    newEntry->rxPriority = RX_PRIO_OTHER;
+    if (filter.has_mac() &&
+        !memcmp(newEntry->mac, linkLocalMac, sizeof(linkLocalMac)) &&
+        ((newEntry->mac[5] & 0xF0) == 0)) {
+        newEntry->rxPriority = RX_PRIO_CONTROL;
+    } else if (isDhcp) {
+        newEntry->rxPriority = RX_PRIO_DHCP;
+    }
+    newEntry->rxQueue = rxQueueAlloc(filterName, newEntry->rxPriority);
+    newEntry->rxFilterSlot = rxFilterSlotAlloc(filterName);
+
+    filterTable.push_back(entry);
+    compileFilterTable();
 
     return ESAL_RC_OK;
 }
@@ -592,17 +2418,19 @@ int VendorDeletePacketFilter(const char *filterName) {
     }
     std::unique_lock<std::mutex> lock(filterTableMutex);
 
-    // Look for match first. 
-    int idx = 0;
-    for (idx = 0; idx < filterTableSize; idx++) {
+    // Look for match first.  Once marked, the published snapshot no
+    // longer matches it.
+    size_t idx = 0;
+    for (idx = 0; idx < filterTable.size(); idx++) {
         if (filterTable[idx].filterName == filterName) {
             filterTable[idx].pendingDelete = true;
+            compileFilterTable();
             break;
         }
     }
 
     // Check to see if match is found
-    if (idx == filterTableSize) {
+    if (idx == filterTable.size()) {
         return ESAL_RC_OK;
     }
 
@@ -620,10 +2448,19 @@ int VendorDeletePacketFilter(const char *filterName) {
         return ESAL_RC_FAIL;
     }
 
-    // Update in the shadow.
-    filterTable[idx] = filterTable[filterTableSize-1];
-    filterTable[idx].pendingDelete = false;
-    filterTableSize--;
+    // Erase in place so the remaining filters keep their order.  Once the
+    // new snapshot is out nothing can queue to its Rx ring, so it can be
+    // recycled.
+    int rxQueue = filterTable[idx].rxQueue;
+    int rxFilterSlot = filterTable[idx].rxFilterSlot;
+    filterTable.erase(filterTable.begin() + idx);
+    compileFilterTable();
+    if (rxQueue >= 0) {
+        rxQueues[rxQueue].inUse = false;
+    }
+    if (rxFilterSlot >= 0) {
+        rxFilterSlots[rxFilterSlot].inUse = false;
+    }
 
     return ESAL_RC_OK;
 }
@@ -648,7 +2485,7 @@ int VendorSendPacket(uint16_t lPort, uint16_t length, const void *buf) {
         return ESAL_RC_FAIL;
     }
 
-    retcode =  sai_api_query(SAI_API_HOSTIF, (void**) &sai_hostif_api);
+    retcode =  esalSaiApiQuery(SAI_API_HOSTIF, (void**) &sai_hostif_api);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query in VendorSendPacket\n"));
@@ -675,6 +2512,7 @@ int VendorSendPacket(uint16_t lPort, uint16_t length, const void *buf) {
     attrList.push_back(attr);
 
     // Send the packet.
+    captureRecord(CAPTURE_TX, lPort, "", buf, length);
     retcode = sai_hostif_api->send_hostif_packet(
         hostInterface, length, buf, attrList.size(), attrList.data());
     if (retcode) {
@@ -687,12 +2525,153 @@ int VendorSendPacket(uint16_t lPort, uint16_t length, const void *buf) {
     return ESAL_RC_OK;
 }
 
+int VendorSendPackets(uint16_t numPkts, const VendorTxPacket *pkts,
+                      uint16_t *numSent) {
+    uint16_t sent = 0;
+    if (numSent) {
+        *numSent = 0;
+    }
+    if (!pkts) {
+        return ESAL_RC_FAIL;
+    }
+
+#ifndef UTS
+    if (!useSaiFlag){
+        if (numSent) {
+            *numSent = numPkts;
+        }
+        return ESAL_RC_OK;
+    }
+
+    sai_hostif_api_t *sai_hostif_api;
+    if (esalSaiApiQuery(SAI_API_HOSTIF, (void**) &sai_hostif_api)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "sai_api_query in VendorSendPackets\n"));
+        return ESAL_RC_FAIL;
+    }
+
+    // Each packet takes the epoch just to copy its template, so a port
+    // map refresh or filter change never waits on a blocking send.
+    uint16_t noPort = 0;
+    uint16_t sendFail = 0;
+    for (uint16_t i = 0; i < numPkts; i++) {
+        const VendorTxPacket &pkt = pkts[i];
+        captureRecord(CAPTURE_TX, pkt.lPort, "", pkt.packet, pkt.length);
+        sai_attribute_t attrs[2];
+        uint32_t slot = filterReadLock();
+        const TxPortTemplate *txPorts =
+            txPortTemplates.load(std::memory_order_acquire);
+        bool cached = txPorts && (pkt.lPort < MAX_CLASSIFIER_PORTS) &&
+                      txPorts[pkt.lPort].valid;
+        if (cached) {
+            attrs[0] = txPorts[pkt.lPort].attrs[0];
+            attrs[1] = txPorts[pkt.lPort].attrs[1];
+        }
+        filterReadUnlock(slot);
+        if (!cached) {
+            // No template yet, look the port up as VendorSendPacket does.
+            uint32_t dev;
+            uint32_t pPort;
+            sai_object_id_t portSai;
+            if (!saiUtils.GetPhysicalPortInfo(pkt.lPort, &dev, &pPort) ||
+                !esalPortTableFindSai(pPort, &portSai)) {
+                noPort++;
+                continue;
+            }
+            txPortAttrsFill(attrs, portSai);
+        }
+        sai_status_t retcode = sai_hostif_api->send_hostif_packet(
+            hostInterface, pkt.length, pkt.packet, 2, attrs);
+        if (retcode) {
+            sendFail++;
+        } else {
+            sent++;
+        }
+    }
+    if (numSent) {
+        *numSent = sent;
+    }
+
+    // One report per batch, not per packet.
+    if (noPort || sendFail) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "send_hostif_packet in VendorSendPackets\n"));
+        std::cout << "VendorSendPackets failed noPort=" << noPort
+                  << " sendFail=" << sendFail << std::endl;
+        return ESAL_RC_FAIL;
+    }
+#else
+    sent = numPkts;
+    if (numSent) {
+        *numSent = sent;
+    }
+#endif
+    return ESAL_RC_OK;
+}
+
+bool esalTxBenchmark(uint16_t lPort, uint32_t numPkts, std::string &report) {
+    // Minimum size frames to the nearest bridge group address with the
+    // local experimental Ethertype, so nothing forwards or acts on them.
+    const uint16_t TX_BENCH_LEN = 60;
+    const uint16_t TX_BENCH_BATCH = 32;
+    uint8_t frame[TX_BENCH_LEN];
+    memset(frame, 0, sizeof(frame));
+    const uint8_t dmac[MAC_SIZE] = {0x01, 0x80, 0xC2, 0x00, 0x00, 0x0F};
+    memcpy(frame, dmac, MAC_SIZE);
+    frame[12] = 0x88;
+    frame[13] = 0xB5;
+
+    VendorTxPacket pkts[TX_BENCH_BATCH];
+    for (auto &pkt : pkts) {
+        pkt.lPort = lPort;
+        pkt.length = TX_BENCH_LEN;
+        pkt.packet = frame;
+    }
+
+    // Single sends, then batches.
+    uint64_t nsecs[2];
+    uint32_t sent[2] = {0, 0};
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numPkts; i++) {
+        if (VendorSendPacket(lPort, TX_BENCH_LEN, frame) == ESAL_RC_OK) {
+            sent[0]++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    nsecs[0] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numPkts; i += TX_BENCH_BATCH) {
+        uint16_t batch = ((numPkts - i) < TX_BENCH_BATCH) ?
+                         (numPkts - i) : TX_BENCH_BATCH;
+        uint16_t numSent = 0;
+        (void) VendorSendPackets(batch, pkts, &numSent);
+        sent[1] += numSent;
+    }
+    end = std::chrono::steady_clock::now();
+    nsecs[1] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   end - start).count();
+
+    std::stringstream ss;
+    ss << "esalTxBenchmark lPort=" << lPort << " packets=" << numPkts
+       << std::endl;
+    ss << "  VendorSendPacket   sent=" << sent[0]
+       << " pps=" << (nsecs[0] ? (sent[0] * 1000000000ULL) / nsecs[0] : 0)
+       << std::endl;
+    ss << "  VendorSendPackets  sent=" << sent[1]
+       << " pps=" << (nsecs[1] ? (sent[1] * 1000000000ULL) / nsecs[1] : 0)
+       << std::endl;
+    report = ss.str();
+    return sent[0] || sent[1];
+}
+
 int esalCreateSaiHost(uint16_t portId, const char *name) {
 #ifndef UTS
     sai_status_t retcode = SAI_STATUS_SUCCESS;
     sai_hostif_api_t *sai_hostif_api;
 
-    retcode =  sai_api_query(SAI_API_HOSTIF, (void**) &sai_hostif_api);
+    retcode =  esalSaiApiQuery(SAI_API_HOSTIF, (void**) &sai_hostif_api);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalCreateSaiHost\n"));
@@ -753,7 +2732,7 @@ int esalRemoveSaiHost(void) {
     sai_hostif_api_t *sai_hostif_api;
 
     // Determina the API
-    retcode =  sai_api_query(SAI_API_HOSTIF, (void**) &sai_hostif_api);
+    retcode =  esalSaiApiQuery(SAI_API_HOSTIF, (void**) &sai_hostif_api);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalRemoveSaiHost\n"));
@@ -774,7 +2753,18 @@ int esalRemoveSaiHost(void) {
 #endif
 
     // Empty the filter table.
-    filterTableSize = 0;
+    std::unique_lock<std::mutex> lock(filterTableMutex);
+    std::vector<FilterEntry> removed;
+    removed.swap(filterTable);
+    compileFilterTable();
+    for (auto &entry : removed) {
+        if (entry.rxQueue >= 0) {
+            rxQueues[entry.rxQueue].inUse = false;
+        }
+        if (entry.rxFilterSlot >= 0) {
+            rxFilterSlots[entry.rxFilterSlot].inUse = false;
+        }
+    }
     return ESAL_RC_OK;
 }
 
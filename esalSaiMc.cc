@@ -130,7 +130,7 @@ int VendorMirrorPort(uint16_t srclPort, uint16_t dstlPort) {
         // Get mirror api
         //
         sai_mirror_api_t *saiMirrorApi;
-        retcode = sai_api_query(SAI_API_MIRROR, (void**) &saiMirrorApi);
+        retcode = esalSaiApiQuery(SAI_API_MIRROR, (void**) &saiMirrorApi);
         if (retcode) {
             SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                 SWERR_FILELINE, "sai_api_query Fail in VendorMirrorPort\n"));
@@ -182,7 +182,7 @@ int VendorMirrorPort(uint16_t srclPort, uint16_t dstlPort) {
         // Get port table api
         //
         sai_port_api_t *saiPortApi;
-        retcode = sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+        retcode = esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
         if (retcode) {
             SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                 SWERR_FILELINE, "sai_api_query Fail in VendorMirrorPort\n"));
@@ -273,7 +273,7 @@ int VendorRemoveMirrorPort(uint16_t srclPort, uint16_t dstlPort) {
         // Get port table api
         //
         sai_port_api_t *saiPortApi;
-        retcode = sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+        retcode = esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
         if (retcode) {
             SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                 SWERR_FILELINE, "sai_api_query Fail " \
@@ -322,7 +322,7 @@ int VendorRemoveMirrorPort(uint16_t srclPort, uint16_t dstlPort) {
             // Get mirror api
             //
             sai_mirror_api_t *saiMirrorApi;
-            retcode = sai_api_query(SAI_API_MIRROR, (void**) &saiMirrorApi);
+            retcode = esalSaiApiQuery(SAI_API_MIRROR, (void**) &saiMirrorApi);
             if (retcode) {
                 SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query Fail " \
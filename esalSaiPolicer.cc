@@ -35,7 +35,7 @@ bool SetBroadcastRateLimiting(uint16_t pPort,
      // Get port table api
     sai_status_t retcode;
     sai_policer_api_t *saiPolicerApi;
-    retcode =  sai_api_query(SAI_API_POLICER, (void**) &saiPolicerApi);
+    retcode =  esalSaiApiQuery(SAI_API_POLICER, (void**) &saiPolicerApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query Fail in SetBroadcastRateLimiting\n"));
@@ -124,7 +124,7 @@ bool SetMulticastRateLimiting(uint16_t pPort,
      // Get port table api
     sai_status_t retcode;
     sai_policer_api_t *saiPolicerApi;
-    retcode =  sai_api_query(SAI_API_POLICER, (void**) &saiPolicerApi);
+    retcode =  esalSaiApiQuery(SAI_API_POLICER, (void**) &saiPolicerApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query Fail in SetMulticastRateLimiting\n"));
@@ -265,7 +265,7 @@ bool get_policer_counter(uint16_t lPort, uint64_t *bcastGreenStats,
         // Get port table api
         sai_status_t retcode;
         sai_policer_api_t *saiPolicerApi;
-        retcode =  sai_api_query(SAI_API_POLICER, (void**) &saiPolicerApi);
+        retcode =  esalSaiApiQuery(SAI_API_POLICER, (void**) &saiPolicerApi);
         if (retcode) {
             SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                         SWERR_FILELINE, "sai_api_query Fail in SetBroadcastRateLimiting\n"));
@@ -306,7 +306,7 @@ bool clear_policer_counter(uint16_t lPort) {
 
         // Get port table api
         sai_policer_api_t *saiPolicerApi;
-        retcode =  sai_api_query(SAI_API_POLICER, (void**) &saiPolicerApi);
+        retcode =  esalSaiApiQuery(SAI_API_POLICER, (void**) &saiPolicerApi);
         if (retcode) {
             SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                         SWERR_FILELINE, "sai_api_query Fail in SetBroadcastRateLimiting\n"));
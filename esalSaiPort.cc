@@ -18,9 +18,15 @@
 #include "headers/esalSaiUtils.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <string>
 #include <cinttypes>
+#include <chrono>
+#include <pthread.h>
+#include <unistd.h>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
 #include <vector>
 #include <map>
 
@@ -35,10 +41,6 @@
 #include "sfp_vendor_api/sfp_vendor_api.h"
 #endif
 
-#ifdef LARCH_ENVIRON
-#include <unistd.h>
-#endif
-
 extern "C" {
 
 // APPROACH TO SEMAPHORE: 
@@ -87,6 +89,105 @@ CPSS_PORT_MANAGER_SGMII_AUTO_NEGOTIATION_STC autoNegFlowControlCfg[MAX_PORT_TABL
 int portTableSize = 0;
 std::mutex portTableMutex; 
 
+// Indexes into portTable by portId, by lPort and by portSai, holding the
+// table index plus one so that zero is empty.  They follow the table's own
+// discipline: an entry's indexes are written before portTableSize is
+// bumped, and a reader only trusts an index below portTableSize whose
+// entry still carries the key, so look-ups stay lock free.  portSai is an
+// open addressed hash, sized at twice the table so probes stay short.
+const int MAX_PORT_KEY_INDEX = 65536;
+const int PORT_SAI_HASH_SIZE = 2 * MAX_PORT_TABLE_SIZE;
+
+struct PortSaiHashEntry {
+    sai_object_id_t portSai;
+    uint16_t index;
+};
+
+static uint16_t portIdIndex[MAX_PORT_KEY_INDEX];
+static uint16_t portLPortIndex[MAX_PORT_KEY_INDEX];
+static PortSaiHashEntry portSaiHash[PORT_SAI_HASH_SIZE];
+
+static inline uint32_t portSaiHashSlot(sai_object_id_t portSai) {
+    uint64_t key = portSai ^ (portSai >> 32);
+    return ((key * 0x9E3779B97F4A7C15ULL) >> 32) % PORT_SAI_HASH_SIZE;
+}
+
+static inline int esalPortTableIndexById(uint16_t portId) {
+    int i = portIdIndex[portId] - 1;
+    if ((i >= 0) && (i < portTableSize) && (portTable[i].portId == portId)) {
+        return i;
+    }
+    return -1;
+}
+
+static inline int esalPortTableIndexByLPort(uint32_t lPort) {
+    if (lPort >= MAX_PORT_KEY_INDEX) {
+        return -1;
+    }
+    int i = portLPortIndex[lPort] - 1;
+    if ((i >= 0) && (i < portTableSize) && (portTable[i].lPort == lPort)) {
+        return i;
+    }
+    return -1;
+}
+
+static int esalPortTableIndexBySai(sai_object_id_t portSai) {
+    uint32_t slot = portSaiHashSlot(portSai);
+    for (int probe = 0; probe < PORT_SAI_HASH_SIZE; probe++) {
+        const PortSaiHashEntry &entry = portSaiHash[slot];
+        if (entry.portSai == SAI_NULL_OBJECT_ID) {
+            return -1;
+        }
+        int i = entry.index - 1;
+        if ((entry.portSai == portSai) && (i >= 0) && (i < portTableSize) &&
+            (portTable[i].portSai == portSai)) {
+            return i;
+        }
+        slot = (slot + 1) % PORT_SAI_HASH_SIZE;
+    }
+    return -1;
+}
+
+// Caller holds portTableMutex, and has not yet bumped portTableSize.  The
+// first entry for a key keeps it, as the linear search used to find.
+static void esalPortTableIndexAdd(int i) {
+    if (esalPortTableIndexById(portTable[i].portId) < 0) {
+        portIdIndex[portTable[i].portId] = i + 1;
+    }
+    uint32_t slot = portSaiHashSlot(portTable[i].portSai);
+    for (int probe = 0; probe < PORT_SAI_HASH_SIZE; probe++) {
+        PortSaiHashEntry &entry = portSaiHash[slot];
+        if (entry.portSai == portTable[i].portSai) {
+            if (esalPortTableIndexBySai(entry.portSai) < 0) {
+                entry.index = i + 1;
+            }
+            return;
+        }
+        if (entry.portSai == SAI_NULL_OBJECT_ID) {
+            entry.index = i + 1;
+            entry.portSai = portTable[i].portSai;
+            return;
+        }
+        slot = (slot + 1) % PORT_SAI_HASH_SIZE;
+    }
+}
+
+static void esalPortStateInvalidate(uint32_t pPort);
+
+// Drops a port's cached state on every return path of a port setter, so a
+// reader racing the change cannot cache the old state after it.
+struct PortStateInvalidator {
+    explicit PortStateInvalidator(uint32_t pPort) : pPort_(pPort) {}
+    ~PortStateInvalidator() { esalPortStateInvalidate(pPort_); }
+    uint32_t pPort_;
+};
+
+static void esalPortTableIndexClear(void) {
+    memset(portIdIndex, 0, sizeof(portIdIndex));
+    memset(portLPortIndex, 0, sizeof(portLPortIndex));
+    memset(portSaiHash, 0, sizeof(portSaiHash));
+}
+
 void esalDumpPortTable(void) {
 
     static int cnt = 0; 
@@ -109,42 +210,36 @@ void processSerdesInit(uint16_t lPort);
 void processRateLimitsInit(uint32_t lPort);
  
 bool esalPortTableFindId(sai_object_id_t portSai, uint16_t* portId) {
-    // Search array for match.
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portSai == portSai) {
-            *portId = portTable[i].portId;
-            return true;
-        }
+    int i = esalPortTableIndexBySai(portSai);
+    if (i >= 0) {
+        *portId = portTable[i].portId;
+        return true;
     }
     *portId = 0;
     return false; 
 }
 
 void esalPortSetStp(uint16_t portId, vendor_stp_state_t stpState) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            portTable[i].stpStateSet = true;
-            portTable[i].stpState = stpState;
-            return;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        portTable[i].stpStateSet = true;
+        portTable[i].stpState = stpState;
     }
 }
 
 bool esalPortGetStp(uint32_t lPort, vendor_stp_state_t &stpState) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].lPort == lPort) {
-            stpState = portTable[i].stpState;
-            return portTable[i].stpStateSet;
-        }
+    int i = esalPortTableIndexByLPort(lPort);
+    if (i >= 0) {
+        stpState = portTable[i].stpState;
+        return portTable[i].stpStateSet;
     }
     return false;
 }
 
 bool esalPortTableIsCopper(uint16_t portId) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            return portTable[i].isCopper;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        return portTable[i].isCopper;
     }
     return false;
 }
@@ -164,7 +259,7 @@ void esalPortSetSpeed(
     //  
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query Fail in esalPortSetSpeed\n"));
@@ -255,42 +350,45 @@ void esalPortSetSpeed(
 
 void esalPortSavePortAttr(
     uint16_t portId, uint16_t lPort, bool autoneg, vendor_speed_t speed, vendor_duplex_t duplex) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            portTable[i].lPort = lPort;
-            portTable[i].autoneg = autoneg;
-            portTable[i].speed = speed;
-            portTable[i].duplex = duplex;
-            return;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i < 0) {
+        return;
+    }
+
+    // Move the lPort index along with the entry.
+    if ((portTable[i].lPort != lPort) &&
+        (esalPortTableIndexByLPort(portTable[i].lPort) == i)) {
+        portLPortIndex[portTable[i].lPort] = 0;
+    }
+    portTable[i].lPort = lPort;
+    if (esalPortTableIndexByLPort(lPort) < 0) {
+        portLPortIndex[lPort] = i + 1;
     }
+    portTable[i].autoneg = autoneg;
+    portTable[i].speed = speed;
+    portTable[i].duplex = duplex;
 }
 
 void esalPortTableSetCopper(uint16_t portId, bool isCopper) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            portTable[i].isCopper = isCopper;
-            return;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        portTable[i].isCopper = isCopper;
     }
     return;
 }
 
 void esalPortTableSetChangeable(uint16_t portId, bool isChange) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            portTable[i].isChangeable = isChange;
-            return;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        portTable[i].isChangeable = isChange;
     }
     return;
 }
 
 bool esalPortTableIsChangeable(uint16_t portId) {
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            return portTable[i].isChangeable;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        return portTable[i].isChangeable;
     }
     return false;
 }
@@ -369,12 +467,10 @@ void esalPortTableSetIfMode(uint16_t portId) {
 }
 
 bool esalPortTableFindSai(uint16_t portId, sai_object_id_t *portSai) {
-    // Search array for match.
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            *portSai = portTable[i].portSai;
-            return true;
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        *portSai = portTable[i].portSai;
+        return true;
     }
     *portSai = SAI_NULL_OBJECT_ID;
     return false; 
@@ -393,10 +489,9 @@ bool esalPortTableGetSaiByIdx(uint16_t idx, sai_object_id_t *portSai) {
 }
 
 SaiPortEntry* esalPortTableGetEntryById(uint16_t portId) {
-    for (int i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portId) {
-            return &portTable[i];
-        }
+    int i = esalPortTableIndexById(portId);
+    if (i >= 0) {
+        return &portTable[i];
     }
     return nullptr;
 }
@@ -418,7 +513,7 @@ bool esalPortTableAddEntry(uint16_t portId, sai_object_id_t *portSai) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in esalPortTableAddEntry\n"));
@@ -469,12 +564,17 @@ bool esalPortTableAddEntry(uint16_t portId, sai_object_id_t *portSai) {
     // Get id from oid
     uint16_t _portId = (uint16_t)GET_OID_VAL(*portSai);
 
-    // Store first in shadow area, and then bump count. 
+    // Store first in shadow area, index it, and then bump count. 
     portTable[portTableSize].portSai = *portSai;
     portTable[portTableSize].portId = _portId;
+    esalPortTableIndexAdd(portTableSize);
     portTableSize++;
+    lock.unlock();
 
-    return true; 
+    // The Rx port cache and Tx templates are built from the port table.
+    esalHostPortMapRefresh();
+
+    return true;
 }
 
 bool esalAddAclToPort(sai_object_id_t portSai,
@@ -486,7 +586,7 @@ bool esalAddAclToPort(sai_object_id_t portSai,
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in esalPortTableAddEntry\n"));
@@ -523,11 +623,9 @@ bool perPortCfgFlowControlInit(uint16_t portNum) {
 
     // 10G ports should not execute code because ports are put FORCE_LINK_DOWN.
     //
-    for(auto i = 0; i < portTableSize; i++) {
-        if (portTable[i].portId == portNum) {
-            if (portTable[i].speed == VENDOR_SPEED_TEN_GIGABIT) return true;
-            break;
-        }
+    int i = esalPortTableIndexById(portNum);
+    if (i >= 0) {
+        if (portTable[i].speed == VENDOR_SPEED_TEN_GIGABIT) return true;
     }
 
 // Port configuration update
@@ -742,7 +840,7 @@ bool esalAddBroadcastPolicer(sai_object_id_t portSai,
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in esalAddBroadcastPolicer\n"));
@@ -774,7 +872,7 @@ bool esalAddMulticastPolicer(sai_object_id_t portSai,
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in esalAddMulticastPolicer\n"));
@@ -839,6 +937,9 @@ int VendorSetPortRate(uint16_t lPort, bool autoneg,
               SWERR_FILELINE, "VendorSetPortRate failed to get pPort\n"));
         return ESAL_RC_FAIL;
     }
+
+    // Re-read the port state once this change is made.
+    PortStateInvalidator invalidateState(pPort);
 #ifndef LARCH_ENVIRON
 #ifndef UTS
     std::string hwid_value = esalProfileMap["hwId"];
@@ -881,7 +982,7 @@ int VendorSetPortRate(uint16_t lPort, bool autoneg,
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query Fail in VendorSetPortRate\n"));
@@ -1041,127 +1142,51 @@ int VendorSetPortRate(uint16_t lPort, bool autoneg,
     return rc;
 }
 
-int VendorGetPortRate(uint16_t lPort, vendor_speed_t *speed) {
-#ifdef DEBUG
-    std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
-#endif
-    int rc  = ESAL_RC_OK;
-    uint32_t dev;
-    uint32_t pPort;
-
-    if (!saiUtils.GetPhysicalPortInfo(lPort, &dev, &pPort)) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-              SWERR_FILELINE, "VendorGetPortRate failed to get pPort\n"));
-        return ESAL_RC_FAIL;
-    }
-
-#ifndef LARCH_ENVIRON
-    // First check to see if supported by SFP library.
-    if (esalSFPLibrarySupport && esalSFPLibrarySupport(lPort)) {
-        std::vector<SFPAttribute> values;
-        SFPAttribute val;
-        val.SFPAttr = SFPSpeed;
-        val.SFPVal.LinkSpeed = *speed;
-        values.push_back(val); 
-        if (!esalSFPGetPort) return ESAL_RC_FAIL;
-        esalSFPGetPort(lPort, values.size(), values.data());
-        *speed = values[0].SFPVal.LinkSpeed;
-        return rc; 
-    }
-#endif
-    if (!useSaiFlag){
-        return ESAL_RC_OK;
-    }
-#ifndef UTS
-    // Get port table api
-    sai_status_t retcode;
-    sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
-    if (retcode) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "sai_api_query fail in VendorGetPortRate\n"));
-        std::cout << "sai_api_query fail: " << esalSaiError(retcode)
-                  << std::endl;
-        return ESAL_RC_FAIL; 
-    }
-
-    // Find the sai port.
-    sai_object_id_t portSai = 0;
-    if (!esalPortTableFindSai(pPort, &portSai)) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "esalPortTableFindSai fail " \
-                            "in VendorGetPortRate\n"));
-        std::cout << "esalPortTableFindSai fail: pPort=" << pPort << std::endl;
-        return ESAL_RC_FAIL; 
-    }
-
-    // Add attributes. 
-    std::vector<sai_attribute_t> attributes;
-    sai_attribute_t attr;
-    attr.id = SAI_PORT_ATTR_SPEED;
-    attributes.push_back(attr); 
-
-    // Set the port attributes
-    retcode = saiPortApi->get_port_attribute(portSai,
-                            attributes.size(), attributes.data());
-    if (retcode) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "get_port_attribute fail in VendorGetPortRate\n"));
-        std::cout << "sai_api_query fail: " << esalSaiError(retcode)
-                  << std::endl;
-        return ESAL_RC_FAIL; 
-    }
-
-    switch (attributes[0].value.u32) {
+static vendor_speed_t esalPortSpeedFromSai(uint32_t mbps) {
+    switch (mbps) {
         case 10:
-            *speed = VENDOR_SPEED_TEN;
-            break;
+            return VENDOR_SPEED_TEN;
         case 100:
-            *speed = VENDOR_SPEED_HUNDRED;
-            break;
+            return VENDOR_SPEED_HUNDRED;
         case 1000:
-            *speed = VENDOR_SPEED_GIGABIT;
-            break;
+            return VENDOR_SPEED_GIGABIT;
         case 2500:
-            *speed = VENDOR_SPEED_TWO_AND_HALF_GIGABIT;
-            break;
+            return VENDOR_SPEED_TWO_AND_HALF_GIGABIT;
         case 10000:
-            *speed = VENDOR_SPEED_TEN_GIGABIT;
-            break;
+            return VENDOR_SPEED_TEN_GIGABIT;
         default:
-            *speed = VENDOR_SPEED_UNKNOWN;
-            std::cout << "Switch statement speed fail: " << attributes[0].value.u32
-                      << std::endl; 
+            std::cout << "Switch statement speed fail: " << mbps << std::endl;
+            return VENDOR_SPEED_UNKNOWN;
     }
-#endif
-
-    return rc;
 }
 
-int VendorGetPortDuplex(uint16_t lPort, vendor_duplex_t *duplex) {
+int VendorGetPortAutoNeg(uint16_t lPort, bool *aneg) {
+
 #ifdef DEBUG
     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
 #endif
+
     int rc  = ESAL_RC_OK;
     uint32_t dev;
     uint32_t pPort;
 
     if (!saiUtils.GetPhysicalPortInfo(lPort, &dev, &pPort)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-              SWERR_FILELINE, "VendorGetPortDuplex failed to get pPort\n"));
+              SWERR_FILELINE, "VendorGetPortAutoNeg failed to get pPort\n"));
         return ESAL_RC_FAIL;
     }
+
 #ifndef LARCH_ENVIRON
     // First check to see if supported by SFP library.
     if (esalSFPLibrarySupport && esalSFPLibrarySupport(lPort)) {
         std::vector<SFPAttribute> values;
         SFPAttribute val;
-        val.SFPAttr = SFPDuplex;
-        val.SFPVal.LinkDuplex = *duplex;
+        val.SFPAttr = SFPAutoNeg;
+        val.SFPVal.AutoNeg = *aneg;
         values.push_back(val); 
-        if (!esalSFPGetPort) return ESAL_RC_FAIL;
+        if (!esalSFPGetPort) return ESAL_RC_FAIL; 
         esalSFPGetPort(lPort, values.size(), values.data());
-        *duplex = values[0].SFPVal.LinkDuplex;
+        *aneg = values[0].SFPVal.AutoNeg;
         return rc; 
     }
 #endif
@@ -1172,10 +1197,10 @@ int VendorGetPortDuplex(uint16_t lPort, vendor_duplex_t *duplex) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "sai_api_query fail in VendorGetPortDuplex\n"));
+            SWERR_FILELINE, "sai_api_query fail in VendorGetPortAutoNeg\n"));
         std::cout << "sai_api_query fail: " << esalSaiError(retcode)
                   << std::endl;
         return ESAL_RC_FAIL; 
@@ -1185,182 +1210,413 @@ int VendorGetPortDuplex(uint16_t lPort, vendor_duplex_t *duplex) {
     sai_object_id_t portSai;
     if (!esalPortTableFindSai(pPort, &portSai)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "esalPortTableFindSai " \
-                            "fail in VendorGetPortDuplex\n"));
+            SWERR_FILELINE, "esalPortTableFindSai fail " \
+                            "in VendorGetPortAutoNeg\n"));
         std::cout << "esalPortTableFindSai fail pPort: " << pPort << std::endl;
-        return ESAL_RC_FAIL;
+        return ESAL_RC_FAIL; 
     }
 #ifdef NOT_SUPPORTED_BY_SAI
     // Add attributes. 
     std::vector<sai_attribute_t> attributes;
     sai_attribute_t attr;
-    attr.id = SAI_PORT_ATTR_FULL_DUPLEX_MODE;
-    attributes.push_back(attr);
+    attr.id = SAI_PORT_ATTR_AUTO_NEG_MODE;
+    attributes.push_back(attr); 
 
     // Set the port attributes
     retcode = saiPortApi->get_port_attribute(portSai,
                             attributes.size(), attributes.data());
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "get_port_attribute " \
-                            "fail in VendorGetPortDuplex\n"));
-        std::cout << "get_port_attr fail: " << esalSaiError(retcode)
-                  << std::endl;
+            SWERR_FILELINE, "get_port_attribute fail " \
+                            "in VendorGetPortAutoNeg\n"));
+        std::cout << "get_port fail: " << esalSaiError(retcode) << std::endl;
         return ESAL_RC_FAIL; 
     }
 
-    *duplex = (attributes[0].value.booldata) ? VENDOR_DUPLEX_FULL :
-                        VENDOR_DUPLEX_HALF;
-#else // NOT_SUPPORTED_BY_SAI
+    *aneg = attributes[0].value.booldata;
+#else
 #ifdef HAVE_MRVL
     // XXX Direct cpss calls in Legacy mode, PortManager does not aware of this.
     // Be carefull
     uint32_t devNum = 0;
     // Get portNum from oid
     uint16_t portNum = (uint16_t)GET_OID_VAL(portSai);
-    int cpssDuplexMode;
-    if (cpssDxChPortDuplexModeGet(devNum, portNum, &cpssDuplexMode) != 0) {
+    GT_BOOL cpssAutoneg;
+    if (cpssDxChPortInbandAutoNegEnableGet(devNum, portNum, &cpssAutoneg) != 0) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-                    SWERR_FILELINE, "VendorGetPortDuplex fail in cpssDxChPortDuplexModeGet\n"));
-        std::cout << "VendorGetPortDuplex fail, for pPort: " << pPort << "\n";
+                    SWERR_FILELINE, "VendorGetPortAutoNeg fail in cpssDxChPortInbandAutoNegEnableGet\n"));
+        std::cout << "VendorGetPortAutoNeg fail, for pPort: " << pPort << "\n";
         return ESAL_RC_FAIL;
     }
-    *duplex = (cpssDuplexMode == CPSS_PORT_HALF_DUPLEX_E) ? VENDOR_DUPLEX_HALF : VENDOR_DUPLEX_FULL;
+    *aneg = (cpssAutoneg) ? true : false;
 #endif
 #endif
+
+
 #endif
 
+    SaiPortEntry* portEntry = esalPortTableGetEntryById(pPort);
+    if (portEntry != nullptr) {
+        portEntry->adminState = true;
+    }
+
     return rc;
 }
 
-int VendorGetPortAutoNeg(uint16_t lPort, bool *aneg) {
-
-#ifdef DEBUG
-    std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
-#endif
-
-    int rc  = ESAL_RC_OK;
+// Fills status for one port from a single get_port_attribute.  For ports
+// handled by the SFP library, speed, autoneg and duplex come from one
+// esalSFPGetPort instead, and SAI supplies oper status and FEC only.
+// *sfpFilled, when given, says the SFP fields are good even if the SAI
+// part then fails.
+static int esalPortStatusFetch(sai_port_api_t *saiPortApi, uint16_t lPort,
+                               VendorPortStatus *status, bool *sfpFilled) {
     uint32_t dev;
     uint32_t pPort;
 
+    if (sfpFilled) {
+        *sfpFilled = false;
+    }
+    memset(status, 0, sizeof(*status));
+    status->lPort = lPort;
+    status->speed = VENDOR_SPEED_UNKNOWN;
+    status->duplex = VENDOR_DUPLEX_UNKNOWN;
+    status->fec = SAI_PORT_FEC_MODE_NONE;
+
     if (!saiUtils.GetPhysicalPortInfo(lPort, &dev, &pPort)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-              SWERR_FILELINE, "VendorGetPortAutoNeg failed to get pPort\n"));
+              SWERR_FILELINE, "VendorGetPortStatus failed to get pPort\n"));
         return ESAL_RC_FAIL;
     }
 
+    bool sfpPort = false;
 #ifndef LARCH_ENVIRON
-    // First check to see if supported by SFP library.
     if (esalSFPLibrarySupport && esalSFPLibrarySupport(lPort)) {
-        std::vector<SFPAttribute> values;
-        SFPAttribute val;
-        val.SFPAttr = SFPAutoNeg;
-        val.SFPVal.AutoNeg = *aneg;
-        values.push_back(val); 
-        if (!esalSFPGetPort) return ESAL_RC_FAIL; 
-        esalSFPGetPort(lPort, values.size(), values.data());
-        *aneg = values[0].SFPVal.AutoNeg;
-        return rc; 
+        if (!esalSFPGetPort) return ESAL_RC_FAIL;
+        SFPAttribute values[3];
+        values[0].SFPAttr = SFPSpeed;
+        values[0].SFPVal.LinkSpeed = VENDOR_SPEED_UNKNOWN;
+        values[1].SFPAttr = SFPAutoNeg;
+        values[1].SFPVal.AutoNeg = false;
+        values[2].SFPAttr = SFPDuplex;
+        values[2].SFPVal.LinkDuplex = VENDOR_DUPLEX_UNKNOWN;
+        esalSFPGetPort(lPort, 3, values);
+        status->speed = values[0].SFPVal.LinkSpeed;
+        status->autoneg = values[1].SFPVal.AutoNeg;
+        status->duplex = values[2].SFPVal.LinkDuplex;
+        sfpPort = true;
+        if (sfpFilled) {
+            *sfpFilled = true;
+        }
     }
 #endif
-    if (!useSaiFlag){
+
+    // Hack to hardcode link state to UP on eval card, as in
+    // VendorGetPortLinkState.
+    if ((saiUtils.GetUnitCode() == "feed") ||
+        (saiUtils.GetUnitCode() == "FEED")) {
+        status->linkUp = true;
+    }
+
+    if (!useSaiFlag || (saiPortApi == nullptr)) {
         return ESAL_RC_OK;
     }
 #ifndef UTS
-    // Get port table api
-    sai_status_t retcode;
-    sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
-    if (retcode) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "sai_api_query fail in VendorGetPortAutoNeg\n"));
-        std::cout << "sai_api_query fail: " << esalSaiError(retcode)
-                  << std::endl;
-        return ESAL_RC_FAIL; 
-    }
-
     // Find the sai port.
     sai_object_id_t portSai;
     if (!esalPortTableFindSai(pPort, &portSai)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "esalPortTableFindSai fail " \
-                            "in VendorGetPortAutoNeg\n"));
+                            "in VendorGetPortStatus\n"));
         std::cout << "esalPortTableFindSai fail pPort: " << pPort << std::endl;
-        return ESAL_RC_FAIL; 
+        return ESAL_RC_FAIL;
     }
+
+    // Add attributes.
+    sai_attribute_t attributes[5];
+    uint32_t attrCount = 0;
+    attributes[attrCount++].id = SAI_PORT_ATTR_OPER_STATUS;
+    attributes[attrCount++].id = SAI_PORT_ATTR_FEC_MODE;
+    if (!sfpPort) {
+        attributes[attrCount++].id = SAI_PORT_ATTR_SPEED;
 #ifdef NOT_SUPPORTED_BY_SAI
-    // Add attributes. 
-    std::vector<sai_attribute_t> attributes;
-    sai_attribute_t attr;
-    attr.id = SAI_PORT_ATTR_AUTO_NEG_MODE;
-    attributes.push_back(attr); 
+        attributes[attrCount++].id = SAI_PORT_ATTR_AUTO_NEG_MODE;
+        attributes[attrCount++].id = SAI_PORT_ATTR_FULL_DUPLEX_MODE;
+#endif
+    }
 
-    // Set the port attributes
-    retcode = saiPortApi->get_port_attribute(portSai,
-                            attributes.size(), attributes.data());
+    // Get the port attributes
+    sai_status_t retcode;
+    retcode = saiPortApi->get_port_attribute(portSai, attrCount, attributes);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "get_port_attribute fail " \
-                            "in VendorGetPortAutoNeg\n"));
+                            "in VendorGetPortStatus\n"));
         std::cout << "get_port fail: " << esalSaiError(retcode) << std::endl;
-        return ESAL_RC_FAIL; 
+        return ESAL_RC_FAIL;
     }
 
-    *aneg = attributes[0].value.booldata;
-#else
+    for (uint32_t i = 0; i < attrCount; i++) {
+        switch (attributes[i].id) {
+            case SAI_PORT_ATTR_OPER_STATUS:
+                status->linkUp = status->linkUp ||
+                    (attributes[i].value.s32 == SAI_PORT_OPER_STATUS_UP);
+                break;
+            case SAI_PORT_ATTR_FEC_MODE:
+                status->fec = attributes[i].value.s32;
+                break;
+            case SAI_PORT_ATTR_SPEED:
+                status->speed = esalPortSpeedFromSai(attributes[i].value.u32);
+                break;
+            case SAI_PORT_ATTR_AUTO_NEG_MODE:
+                status->autoneg = attributes[i].value.booldata;
+                break;
+            case SAI_PORT_ATTR_FULL_DUPLEX_MODE:
+                status->duplex = (attributes[i].value.booldata) ?
+                    VENDOR_DUPLEX_FULL : VENDOR_DUPLEX_HALF;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (sfpPort) {
+        return ESAL_RC_OK;
+    }
+
+#ifndef NOT_SUPPORTED_BY_SAI
 #ifdef HAVE_MRVL
-    // XXX Direct cpss calls in Legacy mode, PortManager does not aware of this.
-    // Be carefull
+    // XXX Direct cpss calls in Legacy mode, as in VendorGetPortDuplex and
+    // VendorGetPortAutoNeg.
     uint32_t devNum = 0;
-    // Get portNum from oid
     uint16_t portNum = (uint16_t)GET_OID_VAL(portSai);
+    int cpssDuplexMode;
+    if (cpssDxChPortDuplexModeGet(devNum, portNum, &cpssDuplexMode) != 0) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                    SWERR_FILELINE, "VendorGetPortStatus fail in cpssDxChPortDuplexModeGet\n"));
+        std::cout << "VendorGetPortStatus fail, for pPort: " << pPort << "\n";
+        return ESAL_RC_FAIL;
+    }
+    status->duplex = (cpssDuplexMode == CPSS_PORT_HALF_DUPLEX_E) ?
+                     VENDOR_DUPLEX_HALF : VENDOR_DUPLEX_FULL;
+
     GT_BOOL cpssAutoneg;
     if (cpssDxChPortInbandAutoNegEnableGet(devNum, portNum, &cpssAutoneg) != 0) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-                    SWERR_FILELINE, "VendorGetPortAutoNeg fail in cpssDxChPortInbandAutoNegEnableGet\n"));
-        std::cout << "VendorGetPortAutoNeg fail, for pPort: " << pPort << "\n";
+                    SWERR_FILELINE, "VendorGetPortStatus fail in cpssDxChPortInbandAutoNegEnableGet\n"));
+        std::cout << "VendorGetPortStatus fail, for pPort: " << pPort << "\n";
         return ESAL_RC_FAIL;
     }
-    *aneg = (cpssAutoneg) ? true : false;
+    status->autoneg = (cpssAutoneg) ? true : false;
+#endif
 #endif
+
+#else
+    (void) sfpPort;
 #endif
 
+    return ESAL_RC_OK;
+}
 
+static sai_port_api_t *esalPortStatusApi(void) {
+    if (!useSaiFlag) {
+        return nullptr;
+    }
+#ifndef UTS
+    sai_status_t retcode;
+    sai_port_api_t *saiPortApi;
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
+    if (retcode) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "sai_api_query fail in VendorGetPortStatus\n"));
+        std::cout << "sai_api_query fail: " << esalSaiError(retcode)
+                  << std::endl;
+        return nullptr;
+    }
+    return saiPortApi;
+#else
+    return nullptr;
 #endif
+}
 
-    SaiPortEntry* portEntry = esalPortTableGetEntryById(pPort);
-    if (portEntry != nullptr) {
-        portEntry->adminState = true;
+static int esalPortStatusGet(uint16_t lPort, VendorPortStatus *status,
+                             bool *sfpFilled) {
+    if (sfpFilled) {
+        *sfpFilled = false;
     }
+    sai_port_api_t *saiPortApi = esalPortStatusApi();
+#ifndef UTS
+    if (useSaiFlag && (saiPortApi == nullptr)) {
+        return ESAL_RC_FAIL;
+    }
+#endif
+    return esalPortStatusFetch(saiPortApi, lPort, status, sfpFilled);
+}
 
-    return rc;
+int VendorGetPortStatus(uint16_t lPort, VendorPortStatus *status) {
+#ifdef DEBUG
+    std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
+#endif
+    if (status == nullptr) {
+        return ESAL_RC_FAIL;
+    }
+    return esalPortStatusGet(lPort, status, nullptr);
 }
 
-int VendorGetPortLinkState(uint16_t lPort, bool *ls) {
+int VendorGetAllPortStatus(uint16_t *numPorts, VendorPortStatus *status) {
 #ifdef DEBUG
-     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
+    std::cout << __PRETTY_FUNCTION__ << std::endl;
 #endif
+    if ((numPorts == nullptr) || (status == nullptr)) {
+        return ESAL_RC_FAIL;
+    }
 
-    // Hack to hardcode link state to UP on eval card
-    // To be removed once SFP Manager is suppported
-    if ((saiUtils.GetUnitCode() == "feed") ||
-        (saiUtils.GetUnitCode() == "FEED")) {
-        if (ls != nullptr) {
-            *ls = true;
-            return ESAL_RC_OK;
+    sai_port_api_t *saiPortApi = esalPortStatusApi();
+#ifndef UTS
+    if (useSaiFlag && (saiPortApi == nullptr)) {
+        *numPorts = 0;
+        return ESAL_RC_FAIL;
+    }
+#endif
+
+    // The table only grows, so walk the entries published at entry.
+    int rc = ESAL_RC_OK;
+    uint16_t maxPorts = *numPorts;
+    uint16_t filled = 0;
+    int tableSize = portTableSize;
+    for (int i = 0; (i < tableSize) && (filled < maxPorts); i++) {
+        uint32_t lPort;
+        if (!saiUtils.GetLogicalPort(0, portTable[i].portId, &lPort)) {
+            continue;
         }
+        if (esalPortStatusFetch(saiPortApi, lPort,
+                                &status[filled], nullptr) != ESAL_RC_OK) {
+            rc = ESAL_RC_FAIL;
+            continue;
+        }
+        filled++;
     }
+    *numPorts = filled;
 
-    int rc  = ESAL_RC_OK;
+    return rc;
+}
+
+// Port state cache serving VendorGetPortLinkState, VendorGetPortRate and
+// VendorGetPortDuplex from memory.  Entries are indexed like portTable and
+// pack the state into one word, so a reader never sees half an update.
+// Port notifications keep an entry current; one older than
+// PORT_STATE_MAX_AGE_NSEC is re-read with VendorGetPortStatus, which
+// reconciles any notification that was lost.  The upper half of the word
+// is a generation bumped by every store and invalidate, so a refresh only
+// stores its read if nothing changed the entry while it was reading.
+struct PortStateCacheEntry {
+    std::atomic<uint64_t> state;
+    std::atomic<uint64_t> updated;
+};
+
+const uint32_t PORT_STATE_VALID = 0x1;
+const uint32_t PORT_STATE_LINK = 0x2;
+const uint32_t PORT_STATE_AUTONEG = 0x4;
+const uint64_t PORT_STATE_MAX_AGE_NSEC = 10ULL * 1000 * 1000 * 1000;
+
+static PortStateCacheEntry portStateCache[MAX_PORT_TABLE_SIZE];
+static std::atomic<uint64_t> portStateHits(0);
+static std::atomic<uint64_t> portStateRefreshes(0);
+
+static uint64_t esalPortStateNow(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t esalPortStatePack(const VendorPortStatus &status) {
+    return PORT_STATE_VALID |
+           (status.linkUp ? PORT_STATE_LINK : 0) |
+           (status.autoneg ? PORT_STATE_AUTONEG : 0) |
+           (static_cast<uint32_t>(status.speed) << 8) |
+           (static_cast<uint32_t>(status.duplex) << 16) |
+           (static_cast<uint32_t>(status.fec) << 24);
+}
+
+static void esalPortStateUnpack(uint32_t state, uint16_t lPort,
+                                VendorPortStatus *status) {
+    status->lPort = lPort;
+    status->linkUp = (state & PORT_STATE_LINK) != 0;
+    status->autoneg = (state & PORT_STATE_AUTONEG) != 0;
+    status->speed = (state >> 8) & 0xFF;
+    status->duplex = (state >> 16) & 0xFF;
+    status->fec = (state >> 24) & 0xFF;
+}
+
+static inline uint64_t esalPortStateNext(uint64_t cur, uint32_t state) {
+    return (((cur >> 32) + 1) << 32) | state;
+}
+
+// Replaces entry i and bumps its generation.
+static void esalPortStateSet(int i, uint32_t state) {
+    uint64_t cur = portStateCache[i].state.load(std::memory_order_relaxed);
+    while (!portStateCache[i].state.compare_exchange_weak(cur,
+               esalPortStateNext(cur, state), std::memory_order_release,
+               std::memory_order_relaxed)) {}
+    if (state) {
+        portStateCache[i].updated.store(esalPortStateNow(),
+                                        std::memory_order_relaxed);
+    }
+}
+
+static void esalPortStateStore(uint32_t pPort, const VendorPortStatus &status) {
+    int i = esalPortTableIndexById(pPort);
+    if (i >= 0) {
+        esalPortStateSet(i, esalPortStatePack(status));
+    }
+}
+
+static void esalPortStateInvalidate(uint32_t pPort) {
+    int i = esalPortTableIndexById(pPort);
+    if (i >= 0) {
+        esalPortStateSet(i, 0);
+    }
+}
+
+static void esalPortStateCacheClear(void) {
+    for (int i = 0; i < MAX_PORT_TABLE_SIZE; i++) {
+        esalPortStateSet(i, 0);
+        portStateCache[i].updated.store(0, std::memory_order_relaxed);
+    }
+}
+
+// See esalPortStatusFetch for *sfpFilled.
+static int esalPortCachedStatusGet(uint16_t lPort, bool forceRefresh,
+                                   VendorPortStatus *status, bool *sfpFilled) {
     uint32_t dev;
     uint32_t pPort;
 
+    if (sfpFilled) {
+        *sfpFilled = false;
+    }
+
     if (!saiUtils.GetPhysicalPortInfo(lPort, &dev, &pPort)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-              SWERR_FILELINE, "VendorGetPortLinkState failed to get pPort\n"));
+              SWERR_FILELINE, "VendorGetPortCachedStatus failed to get pPort\n"));
         return ESAL_RC_FAIL;
     }
 
+    // A changeable port that is down goes to hardware, since the SFP probe
+    // below is what brings it up after a media swap.
+    int i = esalPortTableIndexById(pPort);
+    uint64_t seen = 0;
+    if (i >= 0) {
+        uint64_t updated =
+            portStateCache[i].updated.load(std::memory_order_relaxed);
+        seen = portStateCache[i].state.load(std::memory_order_acquire);
+        uint32_t state = static_cast<uint32_t>(seen);
+        if (!forceRefresh && (state & PORT_STATE_VALID) &&
+            ((esalPortStateNow() - updated) < PORT_STATE_MAX_AGE_NSEC) &&
+            ((state & PORT_STATE_LINK) || !esalPortTableIsChangeable(pPort))) {
+            esalPortStateUnpack(state, lPort, status);
+            portStateHits++;
+            return ESAL_RC_OK;
+        }
+    }
+
 #ifndef LARCH_ENVIRON
     if (esalPortTableIsChangeable(pPort)) {
         // Changeable need to check first to see if hardware has changed.
@@ -1375,53 +1631,111 @@ int VendorGetPortLinkState(uint16_t lPort, bool *ls) {
         esalPortTableSetIfMode(pPort);
     } 
 #endif    
-    if (!useSaiFlag){
-        return ESAL_RC_OK;
+
+    if (esalPortStatusGet(lPort, status, sfpFilled) != ESAL_RC_OK) {
+        return ESAL_RC_FAIL;
     }
-#ifndef UTS
-    // Get port table api
-    sai_status_t retcode;
-    sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
-    if (retcode) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "sai_api_query fail in VendorGetPortLinkState\n"));
-        std::cout << "sai_api_query fail: " << esalSaiError(retcode)
-                  << std::endl;
-        return ESAL_RC_FAIL; 
+    portStateRefreshes++;
+
+    // A notification or setter that got in during the read wins.
+    if ((i >= 0) && portStateCache[i].state.compare_exchange_strong(seen,
+            esalPortStateNext(seen, esalPortStatePack(*status)),
+            std::memory_order_release, std::memory_order_relaxed)) {
+        portStateCache[i].updated.store(esalPortStateNow(),
+                                        std::memory_order_relaxed);
     }
 
-    // Find the sai port.
-    sai_object_id_t portSai;
-    if (!esalPortTableFindSai(pPort, &portSai)) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "esalPortTableFindSai fail " \
-                            "in VendorGetPortLinkState\n"));
-        std::cout << "esalPortTableFindSai fail pPort: " << pPort << std::endl;
-        return ESAL_RC_FAIL; 
+    return ESAL_RC_OK;
+}
+
+int VendorGetPortCachedStatus(uint16_t lPort, bool forceRefresh,
+                              VendorPortStatus *status) {
+    if (status == nullptr) {
+        return ESAL_RC_FAIL;
     }
+    return esalPortCachedStatusGet(lPort, forceRefresh, status, nullptr);
+}
 
-    // Add attributes. 
-    std::vector<sai_attribute_t> attributes;
-    sai_attribute_t attr;
-    attr.id = SAI_PORT_ATTR_OPER_STATUS;
-    attributes.push_back(attr); 
+int VendorGetPortRate(uint16_t lPort, vendor_speed_t *speed) {
+#ifdef DEBUG
+    std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
+#endif
+    // Speed is the SFP library's alone for the ports it handles, so it
+    // stands even if the SAI part of the read fails.
+    VendorPortStatus status;
+    bool sfpFilled;
+    if ((esalPortCachedStatusGet(lPort, false, &status,
+                                 &sfpFilled) != ESAL_RC_OK) && !sfpFilled) {
+        return ESAL_RC_FAIL;
+    }
+    *speed = static_cast<vendor_speed_t>(status.speed);
+    return ESAL_RC_OK;
+}
 
-    // Set the port attributes
-    retcode = saiPortApi->get_port_attribute(portSai,
-                            attributes.size(), attributes.data());
-    if (retcode) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "get_port_attribute fail " \
-                            "in VendorGetPortLinkState\n"));
-        std::cout << "get_port fail: " << esalSaiError(retcode) << std::endl;
+int VendorGetPortDuplex(uint16_t lPort, vendor_duplex_t *duplex) {
+#ifdef DEBUG
+    std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
+#endif
+    // As for speed in VendorGetPortRate.
+    VendorPortStatus status;
+    bool sfpFilled;
+    if ((esalPortCachedStatusGet(lPort, false, &status,
+                                 &sfpFilled) != ESAL_RC_OK) && !sfpFilled) {
         return ESAL_RC_FAIL;
     }
+    *duplex = static_cast<vendor_duplex_t>(status.duplex);
+    return ESAL_RC_OK;
+}
 
-    *ls = (attributes[0].value.u32 == SAI_PORT_OPER_STATUS_UP) ? true : false;
+int VendorGetPortLinkState(uint16_t lPort, bool *ls) {
+#ifdef DEBUG
+     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort  << std::endl;
 #endif
+    VendorPortStatus status;
+    if (VendorGetPortCachedStatus(lPort, false, &status) != ESAL_RC_OK) {
+        return ESAL_RC_FAIL;
+    }
+    *ls = status.linkUp;
+    return ESAL_RC_OK;
+}
 
-    return rc;
+void esalPortStateDump(int32_t lPort, bool forceRefresh, std::string &report) {
+    std::stringstream ss;
+    int tableSize = portTableSize;
+    for (int i = 0; i < tableSize; i++) {
+        uint32_t entryLPort;
+        if (!saiUtils.GetLogicalPort(0, portTable[i].portId, &entryLPort)) {
+            continue;
+        }
+        if ((lPort >= 0) && (entryLPort != static_cast<uint32_t>(lPort))) {
+            continue;
+        }
+        VendorPortStatus status;
+        if (VendorGetPortCachedStatus(entryLPort, forceRefresh,
+                                      &status) != ESAL_RC_OK) {
+            ss << "lPort: " << entryLPort << " status fail\n";
+            continue;
+        }
+        uint64_t updated =
+            portStateCache[i].updated.load(std::memory_order_relaxed);
+        ss << "lPort: " << entryLPort
+           << " link: " << (status.linkUp ? "up" : "down")
+           << " speed: " << static_cast<int>(status.speed)
+           << " duplex: " << static_cast<int>(status.duplex)
+           << " autoneg: " << static_cast<int>(status.autoneg)
+           << " fec: " << static_cast<int>(status.fec)
+           << " age(ms): ";
+        if (updated) {
+            ss << (esalPortStateNow() - updated) / 1000000;
+        } else {
+            ss << "-";
+        }
+        ss << "\n";
+    }
+    ss << "hits: " << portStateHits.load(std::memory_order_relaxed)
+       << " refreshes: " << portStateRefreshes.load(std::memory_order_relaxed)
+       << "\n";
+    report = ss.str();
 }
 
 int VendorEnablePort(uint16_t lPort) {
@@ -1441,11 +1755,14 @@ int VendorEnablePort(uint16_t lPort) {
         return ESAL_RC_FAIL;
     }
 
+    // Re-read the port state once this change is made.
+    PortStateInvalidator invalidateState(pPort);
+
 #ifndef UTS
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorEnablePort\n"));
@@ -1519,11 +1836,14 @@ int VendorDisablePort(uint16_t lPort) {
         return ESAL_RC_FAIL;
     }
 
+    // Re-read the port state once this change is made.
+    PortStateInvalidator invalidateState(pPort);
+
 #ifndef UTS
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorDisablePort\n"));
@@ -1585,7 +1905,7 @@ int VendorSetFrameMax(uint16_t lPort, uint16_t size) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorSetFrameMax\n"));
@@ -1649,7 +1969,7 @@ int VendorGetFrameMax(uint16_t lPort, uint16_t *size) {
     // Get api interface. 
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorGetFrameMax\n"));
@@ -1702,6 +2022,9 @@ int VendorSetPortAdvertAbility(uint16_t lPort, uint16_t cap) {
         return ESAL_RC_FAIL;
     }
 
+    // Re-read the port state once this change is made.
+    PortStateInvalidator invalidateState(pPort);
+
 #ifndef LARCH_ENVIRON
     // Set Port Advertising Capability
     if (esalSFPLibrarySupport && esalSFPLibrarySupport(lPort)) {
@@ -1725,7 +2048,7 @@ int VendorSetPortAdvertAbility(uint16_t lPort, uint16_t cap) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "get_port_attribute fail in VendorGetFrameMax\n"));
@@ -1891,7 +2214,7 @@ int VendorGetPortAdvertAbility(uint16_t lPort, uint16_t *advert) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail " \
@@ -2136,33 +2459,39 @@ void esalPortTableState(sai_object_id_t portSai, bool portState){
         esalSFPSetPort(lPort, values.size(), values.data());
     }
 #endif
-    if (!portStateChangeCb) return;
-
-    vendor_speed_t speed;
-    bool autoneg;
-    vendor_duplex_t duplex;
-
-    if (VendorGetPortRate(lPort, &speed) != ESAL_RC_OK) {
+    // Speed, autoneg and duplex in one round trip.  The notification is
+    // authoritative for link, so cache it with the rest.
+    VendorPortStatus status;
+    if (VendorGetPortStatus(lPort, &status) != ESAL_RC_OK) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "VendorGetPortRate fail in esalPortTableState\n"));
-        std::cout << "VendorGetPortRate fail lPort: " << lPort << std::endl;
-    }
-
-    if (VendorGetPortAutoNeg(lPort, &autoneg) != ESAL_RC_OK) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "VendorGetPortAutoNeg fail " \
+            SWERR_FILELINE, "VendorGetPortStatus fail " \
                             "in esalPortTableState\n"));
-        std::cout << "VendorGetPortAutoNeg fail lPort: " << lPort << std::endl;
+        std::cout << "VendorGetPortStatus fail lPort: " << lPort << std::endl;
+        esalPortStateInvalidate(pPort);
+    } else {
+        status.linkUp = portState;
+        esalPortStateStore(pPort, status);
     }
 
-    if (VendorGetPortDuplex(lPort, &duplex) != ESAL_RC_OK) {
-        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-            SWERR_FILELINE, "VendorGetPortDuplex fail " \
-                            "in esalPortTableState\n"));
-        std::cout << "VendorGetPortDuplex fail lPort: "
-                  << lPort << std::endl;
+    if (!portStateChangeCb) return;
+
+    // Reading autoneg back through VendorGetPortAutoNeg used to mark a port
+    // not handled by the SFP library admin up here; keep doing so.
+    bool sfpPort = false;
+#ifndef LARCH_ENVIRON
+    sfpPort = esalSFPLibrarySupport && esalSFPLibrarySupport(lPort);
+#endif
+    if (useSaiFlag && !sfpPort) {
+        SaiPortEntry* portEntry = esalPortTableGetEntryById(pPort);
+        if (portEntry != nullptr) {
+            portEntry->adminState = true;
+        }
     }
 
+    vendor_speed_t speed = static_cast<vendor_speed_t>(status.speed);
+    bool autoneg = status.autoneg;
+    vendor_duplex_t duplex = static_cast<vendor_duplex_t>(status.duplex);
+
     portStateChangeCb(portStateCbData, lPort, portState,
                       autoneg, speed, duplex);
 
@@ -2173,6 +2502,261 @@ void esalPortTableState(sai_object_id_t portSai, bool portState){
     }
 }
 
+// Link events are handed from the SAI notification thread to the ESAL
+// link worker.  With no debounce every event is queued and applied in
+// order, just as if it had been handled inline.  With a debounce each port
+// table entry keeps only its latest state, so rapid up/down sequences
+// coalesce, and the worker calls esalPortTableState once that state has
+// held for the debounce time and differs from the state last delivered.
+// The worker sleeps until an event arrives or the earliest pending port
+// settles.
+struct PortLinkEvent {
+    bool pending;
+    bool up;
+    bool seen;
+    uint64_t changed;
+    uint32_t settled;
+    uint64_t events;
+    uint64_t transitions;
+    uint64_t delivered;
+};
+
+struct LinkEventQueued {
+    int index;
+    bool up;
+};
+
+const uint32_t LINK_SETTLED_VALID = 0x1;
+const uint32_t LINK_SETTLED_UP = 0x2;
+const uint32_t LINK_DEBOUNCE_MAX_MSEC = 10000;
+
+static PortLinkEvent portLinkEvents[MAX_PORT_TABLE_SIZE];
+static std::deque<LinkEventQueued> linkEventQueue;
+static std::mutex linkEventMutex;
+static std::condition_variable linkEventCv;
+static uint64_t linkDebounceNsec = 0;
+static bool linkWorkerLeave = false;
+static std::atomic<bool> linkWorkerRunning(false);
+static pthread_t linkWorkerTid;
+
+// Caller holds linkEventMutex.
+static void esalLinkEventClearLocked(void) {
+    memset(portLinkEvents, 0, sizeof(portLinkEvents));
+    linkEventQueue.clear();
+}
+
+static void esalLinkEventClear(void) {
+    std::unique_lock<std::mutex> lock(linkEventMutex);
+    esalLinkEventClearLocked();
+}
+
+// Records port i as settled in state up.  Returns false, and records
+// nothing, for a debounced bounce back to the state already delivered.
+// Caller holds linkEventMutex.
+static bool esalLinkEventSettleLocked(int i, bool up) {
+    PortLinkEvent &e = portLinkEvents[i];
+    uint32_t settled = LINK_SETTLED_VALID | (up ? LINK_SETTLED_UP : 0);
+    if (linkDebounceNsec && (e.settled == settled)) {
+        return false;
+    }
+    e.settled = settled;
+    e.delivered++;
+    return true;
+}
+
+// Takes what is ready for delivery: the whole queue, and the debounced
+// ports that have settled, or all of them when force is set.  Sets
+// *deadline to when the next pending port settles, zero if none.  Caller
+// holds linkEventMutex.
+static void esalLinkEventCollectLocked(bool force,
+    std::vector<LinkEventQueued> &ready, uint64_t *deadline) {
+    *deadline = 0;
+    for (auto &ev : linkEventQueue) {
+        if (esalLinkEventSettleLocked(ev.index, ev.up)) {
+            ready.push_back(ev);
+        }
+    }
+    linkEventQueue.clear();
+
+    uint64_t now = esalPortStateNow();
+    int tableSize = portTableSize;
+    for (int i = 0; i < tableSize; i++) {
+        PortLinkEvent &e = portLinkEvents[i];
+        if (!e.pending) {
+            continue;
+        }
+        uint64_t due = e.changed + linkDebounceNsec;
+        if (!force && (now < due)) {
+            if (!*deadline || (due < *deadline)) {
+                *deadline = due;
+            }
+            continue;
+        }
+        e.pending = false;
+        if (esalLinkEventSettleLocked(i, e.up)) {
+            ready.push_back({i, e.up});
+        }
+    }
+}
+
+static void esalLinkEventDeliver(const std::vector<LinkEventQueued> &ready) {
+    for (auto &ev : ready) {
+        esalPortTableState(portTable[ev.index].portSai, ev.up);
+    }
+}
+
+static void *esalLinkWorker(void*) {
+    std::vector<LinkEventQueued> ready;
+    std::unique_lock<std::mutex> lock(linkEventMutex);
+    while (!linkWorkerLeave) {
+        uint64_t deadline;
+        ready.clear();
+        esalLinkEventCollectLocked(false, ready, &deadline);
+        if (!ready.empty()) {
+            // Deliver without the lock so notifications keep flowing.
+            lock.unlock();
+            esalLinkEventDeliver(ready);
+            lock.lock();
+            continue;
+        }
+        if (deadline) {
+            linkEventCv.wait_until(lock, std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(deadline)));
+        } else {
+            linkEventCv.wait(lock);
+        }
+    }
+    lock.unlock();
+    pthread_exit(NULL);
+    return 0;
+}
+
+bool esalLinkEventStart(uint32_t debounceMsec) {
+    if (linkWorkerRunning) {
+        return true;
+    }
+
+    if (debounceMsec > LINK_DEBOUNCE_MAX_MSEC) {
+        debounceMsec = LINK_DEBOUNCE_MAX_MSEC;
+    }
+    {
+        std::unique_lock<std::mutex> lock(linkEventMutex);
+        linkDebounceNsec = static_cast<uint64_t>(debounceMsec) * 1000000;
+        esalLinkEventClearLocked();
+        linkWorkerLeave = false;
+    }
+
+    if (pthread_create(&linkWorkerTid, NULL, esalLinkWorker, NULL)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+            SWERR_FILELINE, "pthread_create fail in esalLinkEventStart\n"));
+        std::cout << "ERROR esalLinkEventStart fail\n";
+        return false;
+    }
+    (void) pthread_setname_np(linkWorkerTid, "ESALLinkEvent");
+    linkWorkerRunning = true;
+    std::cout << "Link Event Debounce Msec: " << debounceMsec
+              << "\n" << std::flush;
+    return true;
+}
+
+void esalLinkEventStop(void) {
+    {
+        std::unique_lock<std::mutex> lock(linkEventMutex);
+        if (!linkWorkerRunning) {
+            return;
+        }
+        linkWorkerLeave = true;
+    }
+    linkEventCv.notify_one();
+    pthread_join(linkWorkerTid, NULL);
+
+    // Notifications keep being queued while this thread takes over
+    // delivery, so nothing older can land after something newer.  Once
+    // nothing is left, and under the same lock, hand over to inline.
+    std::vector<LinkEventQueued> ready;
+    uint64_t deadline;
+    std::unique_lock<std::mutex> lock(linkEventMutex);
+    while (true) {
+        ready.clear();
+        esalLinkEventCollectLocked(true, ready, &deadline);
+        if (ready.empty()) {
+            linkWorkerRunning = false;
+            break;
+        }
+        lock.unlock();
+        esalLinkEventDeliver(ready);
+        lock.lock();
+    }
+}
+
+void esalEnqueueLinkEvents(uint32_t count,
+                           const sai_port_oper_status_notification_t *ntif) {
+    if (!ntif) return;
+
+    for (uint32_t n = 0; n < count; n++) {
+        bool up = (ntif[n].port_state == SAI_PORT_OPER_STATUS_UP);
+        int i = esalPortTableIndexBySai(ntif[n].port_id);
+
+        {
+            std::unique_lock<std::mutex> lock(linkEventMutex);
+            if (linkWorkerRunning && (i >= 0)) {
+                PortLinkEvent &e = portLinkEvents[i];
+                e.events++;
+                if (e.seen && (e.up != up)) {
+                    e.transitions++;
+                }
+                e.seen = true;
+                e.up = up;
+                if (linkDebounceNsec) {
+                    e.changed = esalPortStateNow();
+                    e.pending = true;
+                } else {
+                    linkEventQueue.push_back({i, up});
+                }
+                lock.unlock();
+                linkEventCv.notify_one();
+                continue;
+            }
+        }
+
+        // Without the worker, or for a port not in the table, stay inline.
+        esalPortTableState(ntif[n].port_id, up);
+    }
+}
+
+void esalLinkEventDump(bool clear, std::string &report) {
+    std::stringstream ss;
+    std::unique_lock<std::mutex> lock(linkEventMutex);
+    ss << "debounce(ms): " << linkDebounceNsec / 1000000
+       << (linkWorkerRunning ? "" : " (inline)") << "\n";
+    int tableSize = portTableSize;
+    for (int i = 0; i < tableSize; i++) {
+        PortLinkEvent &e = portLinkEvents[i];
+        if (!e.events) {
+            continue;
+        }
+        uint32_t lPort;
+        if (!saiUtils.GetLogicalPort(0, portTable[i].portId, &lPort)) {
+            continue;
+        }
+        ss << "lPort: " << lPort
+           << " settled: " << (!(e.settled & LINK_SETTLED_VALID) ? "-" :
+                               (e.settled & LINK_SETTLED_UP) ? "up" : "down")
+           << " events: " << e.events
+           << " flaps: " << e.transitions
+           << " delivered: " << e.delivered
+           << " coalesced: "
+           << ((e.events > e.delivered) ? e.events - e.delivered : 0)
+           << "\n";
+        if (clear) {
+            e.events = 0;
+            e.transitions = 0;
+            e.delivered = 0;
+        }
+    }
+    report = ss.str();
+}
+
 int VendorResetPort(uint16_t lPort) {
     std::cout << __PRETTY_FUNCTION__ << " lPort=" << lPort << std::endl;
 
@@ -2191,6 +2775,12 @@ int VendorResetPort(uint16_t lPort) {
     VendorDisablePort(lPort);
     sleep(1);
     VendorEnablePort(lPort);
+
+    uint32_t dev;
+    uint32_t pPort;
+    if (saiUtils.GetPhysicalPortInfo(lPort, &dev, &pPort)) {
+        esalPortStateInvalidate(pPort);
+    }
     return ESAL_RC_OK;
 }
 
@@ -2278,7 +2868,7 @@ int VendorDropTaggedPacketsOnIngress(uint16_t lPort) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail " \
@@ -2339,7 +2929,7 @@ int VendorDropUntaggedPacketsOnIngress(uint16_t lPort) {
     // Get port table api
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail " \
@@ -2546,7 +3136,6 @@ bool portWarmBootSaveHandler() {
     // Saving a current operation state for ports
     //
     for (int i = 0; i < portTableSize; i++) {
-        bool ls;
         uint16_t pPort;
         uint32_t lPort;
 
@@ -2555,13 +3144,16 @@ bool portWarmBootSaveHandler() {
         if (!saiUtils.GetLogicalPort(0, pPort, &lPort)) {
             continue;
         }
-        if (VendorGetPortLinkState(lPort, &ls) != ESAL_RC_OK) {
-            std::cout << "Error VendorGetPortLinkState: " << lPort << std::endl;
+        // Read oper status straight from hardware, bypassing the cache
+        // and its changeable SFP probe.
+        VendorPortStatus portStatus;
+        if (VendorGetPortStatus(lPort, &portStatus) != ESAL_RC_OK) {
+            std::cout << "Error VendorGetPortStatus: " << lPort << std::endl;
             status &= false;
             continue;
         }
 
-        portTable[i].operationState = ls;
+        portTable[i].operationState = portStatus.linkUp;
     }
 
     if (!serializePortTableConfig(portTable, portTableSize, BACKUP_FILE_PORT)) {
@@ -2631,8 +3223,14 @@ bool portWarmBootRestoreHandler () {
 }
 
 void portWarmBootCleanHandler() {
-    std::unique_lock<std::mutex> lock(portTableMutex);
-    portTableSize = 0;
+    {
+        std::unique_lock<std::mutex> lock(portTableMutex);
+        portTableSize = 0;
+        esalPortTableIndexClear();
+        esalPortStateCacheClear();
+        esalLinkEventClear();
+    }
+    esalHostPortMapRefresh();
 }
 
 }
@@ -138,7 +138,7 @@ int VendorGetL2Pm(uint16_t *usedLen, uint16_t maxLen, char* gpbBuf) {
         // Get the API for port.
         sai_status_t retcode;
         sai_port_api_t *saiPortApi;
-        retcode =  sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+        retcode =  esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
         if (retcode) {
             std::cout << "sai_api_query fail: " << esalSaiError(retcode)
                       << std::endl;
@@ -79,7 +79,7 @@ int VendorSetPortStpState(uint16_t lPort, vendor_stp_state_t stpState) {
     sai_stp_api_t *saiStpApi;
     sai_attribute_t attr;
 
-    auto retcode = sai_api_query(SAI_API_STP, (void**) &saiStpApi);
+    auto retcode = esalSaiApiQuery(SAI_API_STP, (void**) &saiStpApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorSetPortStpState\n"));
@@ -154,7 +154,7 @@ int VendorGetPortStpState(uint16_t lPort, vendor_stp_state_t *stpState) {
     sai_status_t retcode;
     sai_stp_api_t *saiStpApi;
     
-    retcode = sai_api_query(SAI_API_STP, (void**) &saiStpApi);
+    retcode = esalSaiApiQuery(SAI_API_STP, (void**) &saiStpApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorGetPortStpState\n"));
@@ -215,7 +215,7 @@ bool esalStpCreate(sai_object_id_t *defStpId) {
     // Get the STP API
     //
     sai_stp_api_t *saiStpApi;
-    auto retcode =  sai_api_query(SAI_API_STP, (void**) &saiStpApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_STP, (void**) &saiStpApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalStpCreate\n"));
@@ -245,7 +245,7 @@ bool esalStpPortCreate(sai_object_id_t stpSai, sai_object_id_t bridgePortSai, sa
     
 #ifndef UTS
     sai_stp_api_t *saiStpApi;
-    auto retcode =  sai_api_query(SAI_API_STP, (void**) &saiStpApi);
+    auto retcode =  esalSaiApiQuery(SAI_API_STP, (void**) &saiStpApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query fail in esalStpPortCreate\n"));
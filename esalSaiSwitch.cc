@@ -18,6 +18,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 
 #include <string>
 #include <cinttypes>
@@ -430,20 +431,16 @@ static void onSwitchStateChange(sai_object_id_t sid, sai_switch_oper_status_t sw
 
 static void onFdbEvent(uint32_t count, sai_fdb_event_notification_data_t *data)
 {
-    (void) data; 
-    for(uint32_t i = 0; i < count; i++) {
-        (void) esalAlterForwardingTable(data+i);
-    }
+    // Hand off to the FDB worker, never do table work on the SAI thread.
+    esalEnqueueFdbEvents(count, data);
 }
 
 
 static void onPortStateChange(uint32_t count, sai_port_oper_status_notification_t *ntif)
 {
     std::cout << "onPortStateChange: " << count << "\n";
-    for(uint32_t i = 0; i < count; i++) {
-        esalPortTableState(
-            ntif[i].port_id, (ntif[i].port_state == SAI_PORT_OPER_STATUS_UP));
-    }
+    // Hand off to the link worker, which debounces and applies them.
+    esalEnqueueLinkEvents(count, ntif);
 }
 
 #if 0
@@ -471,6 +468,15 @@ static int get_mac_addr(const char* interfaceName, sai_mac_t* mac) {
 }
 #endif
 
+// Warm restart FDB resync.  The hardware table is scanned in chunks, each
+// chunk is turned into a batch of LEARNED events and handed to the FDB
+// worker in one go.  Bridge port lookups are cached per physical port for
+// the whole scan.  Entries that can't be translated are skipped and
+// counted rather than aborting the resync.
+const uint32_t FDB_RESYNC_DEFAULT_CHUNK = 1024;
+const uint32_t FDB_RESYNC_MAX_PORT = 1024;
+static uint32_t esalFdbResyncChunk = FDB_RESYNC_DEFAULT_CHUNK;
+
 static int esalWarmRestartReNotifyFdb()
 {
     CPSS_MAC_ENTRY_EXT_STC entry;
@@ -481,9 +487,9 @@ static int esalWarmRestartReNotifyFdb()
     GT_BOOL aged[2] = {GT_FALSE, GT_FALSE};
     GT_STATUS rc;
     GT_U32 tblSize;
-    sai_fdb_event_notification_data_t data;
-    sai_attribute_t fdb_attribute[3];
-    sai_packet_action_t saiAction = SAI_PACKET_ACTION_FORWARD;;
+    sai_packet_action_t saiAction = SAI_PACKET_ACTION_FORWARD;
+    uint32_t chunk = esalFdbResyncChunk ?
+                     esalFdbResyncChunk : FDB_RESYNC_DEFAULT_CHUNK;
 
     rc = cpssDxChCfgTableNumEntriesGet(cpssDevNum, CPSS_DXCH_CFG_TABLE_FDB_E,
                                        &tblSize);
@@ -495,98 +501,158 @@ static int esalWarmRestartReNotifyFdb()
                   << rc << std::endl;
         return ESAL_RC_FAIL;
     }
+    if (!tblSize) {
+        return ESAL_RC_OK;
+    }
+    if (chunk > tblSize) {
+        chunk = tblSize;
+    }
+
+    // Per-chunk event and attribute storage, reused for every chunk.  The
+    // ring copies the events, so nothing here needs to outlive the push.
+    std::vector<sai_fdb_event_notification_data_t> events(chunk);
+    std::vector<sai_attribute_t> attrs(chunk * 3);
 
-    for (GT_U32 entryIndex = 0; entryIndex < tblSize; entryIndex++)
+    // Bridge port cache indexed by physical port.
+    std::vector<sai_object_id_t> bridgePortCache(FDB_RESYNC_MAX_PORT);
+    std::vector<uint8_t> bridgePortKnown(FDB_RESYNC_MAX_PORT, 0);
+
+    uint32_t numValid = 0;
+    uint32_t numReadFail = 0;
+    uint32_t numBadPort = 0;
+    uint32_t numBadCmd = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (GT_U32 chunkBase = 0; chunkBase < tblSize; chunkBase += chunk)
     {
-        rc = cpssDxChBrgFdbMacEntryRead(cpssDevNum, entryIndex, &valid, &skip,
-                                        &aged[cpssDevNum], &associatedHwDevNum, &entry);
-        if (rc != GT_OK)
-        {
-                SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-                            SWERR_FILELINE, "cpssDxChBrgFdbMacEntryRead failed\n"));
-                std::cout << "cpssDxChBrgFdbMacEntryRead fail: "
-                          << rc << std::endl;
-                return ESAL_RC_FAIL;
-        }
+        GT_U32 chunkEnd = ((tblSize - chunkBase) > chunk) ?
+                          (chunkBase + chunk) : tblSize;
+        uint32_t batchCnt = 0;
 
-        if (!valid)
+        for (GT_U32 entryIndex = chunkBase; entryIndex < chunkEnd; entryIndex++)
         {
-            continue;
-        }
+            rc = cpssDxChBrgFdbMacEntryRead(cpssDevNum, entryIndex, &valid, &skip,
+                                            &aged[cpssDevNum], &associatedHwDevNum, &entry);
+            if (rc != GT_OK)
+            {
+                numReadFail++;
+                continue;
+            }
 
-        // We should notify XPS layer also
-        // Needs for address aging
-#ifndef UTS
-        if (!entry.isStatic)
-        {
-            macAddressData[entryIndex].valid = true;
-            macAddressData[entryIndex].macAge = 0;
-        }
+            if (!valid)
+            {
+                continue;
+            }
 
-#endif
-        memset(&data, 0x0, sizeof(sai_fdb_event_notification_data_t));
+            // Translate the egress port, looking each port up only once.
+            GT_U32 portNum = entry.dstInterface.devPort.portNum;
+            sai_object_id_t bridgePortSai;
+            if (portNum < FDB_RESYNC_MAX_PORT) {
+                if (!bridgePortKnown[portNum]) {
+                    bridgePortKnown[portNum] =
+                        esalFindBridgePortSaiFromPortId(
+                            portNum, &bridgePortCache[portNum]) ? 1 : 2;
+                }
+                if (bridgePortKnown[portNum] != 1) {
+                    numBadPort++;
+                    continue;
+                }
+                bridgePortSai = bridgePortCache[portNum];
+            } else if (!esalFindBridgePortSaiFromPortId(portNum, &bridgePortSai)) {
+                numBadPort++;
+                continue;
+            }
 
-        data.fdb_entry.switch_id = esalSwitchId;
-        data.event_type = SAI_FDB_EVENT_LEARNED;
+            //Packet action
+            switch (entry.daCommand)
+            {
+            case CPSS_MAC_TABLE_FRWRD_E:
+                    saiAction = SAI_PACKET_ACTION_FORWARD;
+                    break;
 
-        data.fdb_entry.bv_id = ((uint64_t)SAI_OBJECT_TYPE_VLAN << 48) | entry.key.key.macVlan.vlanId;
-        memcpy(data.fdb_entry.mac_address, entry.key.key.macVlan.macAddr.arEther, sizeof(sai_mac_t));
+            case CPSS_MAC_TABLE_DROP_E:
+                    saiAction = SAI_PACKET_ACTION_DROP;
+                    break;
 
-        data.attr_count = 3;
+            case CPSS_MAC_TABLE_INTERV_E:
+                    saiAction = SAI_PACKET_ACTION_DROP;
+                    break;
 
-        //Fdb entry type
-        fdb_attribute[0].id = SAI_FDB_ENTRY_ATTR_TYPE;
-        fdb_attribute[0].value.s32 = (entry.isStatic == true) ?
-                                     SAI_FDB_ENTRY_TYPE_STATIC : SAI_FDB_ENTRY_TYPE_DYNAMIC;
+            case CPSS_MAC_TABLE_CNTL_E:
+                    saiAction = SAI_PACKET_ACTION_TRAP;
+                    break;
 
-        fdb_attribute[1].id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
-        if (!esalFindBridgePortSaiFromPortId(entry.dstInterface.devPort.portNum,
-                                             &fdb_attribute[1].value.oid))
-        {
-            std::cout << "port_table_find_sai fail pPort:" << entry.dstInterface.devPort.portNum << std::endl;
-            return ESAL_RC_FAIL;
-        }
+            case CPSS_MAC_TABLE_MIRROR_TO_CPU_E:
+                    saiAction = SAI_PACKET_ACTION_COPY;
+                    break;
 
-        //Packet action
-        fdb_attribute[2].id = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
-        switch (entry.daCommand)
-        {
-        case CPSS_MAC_TABLE_FRWRD_E:
-                saiAction = SAI_PACKET_ACTION_FORWARD;
-                break;
+            case CPSS_MAC_TABLE_SOFT_DROP_E:
+                    break;
 
-        case CPSS_MAC_TABLE_DROP_E:
-                saiAction = SAI_PACKET_ACTION_DROP;
-                break;
+            default:
+                    numBadCmd++;
+                    continue;
+            }
 
-        case CPSS_MAC_TABLE_INTERV_E:
-                saiAction = SAI_PACKET_ACTION_DROP;
-                break;
+            // We should notify XPS layer also
+            // Needs for address aging
+#ifndef UTS
+            if (!entry.isStatic)
+            {
+                macAddressData[entryIndex].valid = true;
+                macAddressData[entryIndex].macAge = 0;
+            }
 
-        case CPSS_MAC_TABLE_CNTL_E:
-                saiAction = SAI_PACKET_ACTION_TRAP;
-                break;
+#endif
+            auto &data = events[batchCnt];
+            sai_attribute_t *fdb_attribute = &attrs[batchCnt * 3];
+            memset(&data, 0x0, sizeof(sai_fdb_event_notification_data_t));
 
-        case CPSS_MAC_TABLE_MIRROR_TO_CPU_E:
-                saiAction = SAI_PACKET_ACTION_COPY;
-                break;
+            data.fdb_entry.switch_id = esalSwitchId;
+            data.event_type = SAI_FDB_EVENT_LEARNED;
 
-        case CPSS_MAC_TABLE_SOFT_DROP_E:
-                break;
+            data.fdb_entry.bv_id = ((uint64_t)SAI_OBJECT_TYPE_VLAN << 48) | entry.key.key.macVlan.vlanId;
+            memcpy(data.fdb_entry.mac_address, entry.key.key.macVlan.macAddr.arEther, sizeof(sai_mac_t));
 
-        default:
-                SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
-                            SWERR_FILELINE, "fdb entry DA command is unknown\n"));
-                std::cout << "fdb entry DA command is unknown"
-                          << rc << std::endl;
-                return ESAL_RC_FAIL;
+            data.attr_count = 3;
+
+            //Fdb entry type
+            fdb_attribute[0].id = SAI_FDB_ENTRY_ATTR_TYPE;
+            fdb_attribute[0].value.s32 = (entry.isStatic == true) ?
+                                         SAI_FDB_ENTRY_TYPE_STATIC : SAI_FDB_ENTRY_TYPE_DYNAMIC;
+
+            fdb_attribute[1].id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
+            fdb_attribute[1].value.oid = bridgePortSai;
+
+            fdb_attribute[2].id = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
+            fdb_attribute[2].value.s32 = saiAction;
+
+            data.attr = fdb_attribute;
+            batchCnt++;
+            numValid++;
         }
 
-        fdb_attribute[2].value.s32 = saiAction;
+        if (batchCnt) {
+            esalEnqueueFdbResyncEvents(batchCnt, events.data());
+        }
+    }
 
-        data.attr = fdb_attribute;
- 
-        onFdbEvent(1, &data);
+    auto end = std::chrono::steady_clock::now();
+    uint64_t usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+                         end - start).count();
+    uint32_t numSkipped = numReadFail + numBadPort + numBadCmd;
+    std::cout << "esalWarmRestartReNotifyFdb scanned: " << tblSize
+              << " valid: " << numValid
+              << " skipped: " << numSkipped
+              << " (readFail: " << numReadFail
+              << " badPort: " << numBadPort
+              << " badCmd: " << numBadCmd << ")"
+              << " usec: " << usecs
+              << " entries/sec: " << (usecs ? (numValid * 1000000ULL) / usecs : 0)
+              << "\n" << std::flush;
+    if (numSkipped) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+                    SWERR_FILELINE, "esalWarmRestartReNotifyFdb skipped entries\n"));
     }
 
     return ESAL_RC_OK;
@@ -602,6 +668,86 @@ void onPacketEvent(sai_object_id_t sid,
 
 #endif
 
+#ifndef UTS
+EsalSaiApis::EsalSaiApis() : valid_(false) {
+    memset(tables_, 0, sizeof(tables_));
+}
+
+EsalSaiApis &EsalSaiApis::instance(void) {
+    static EsalSaiApis apis;
+    return apis;
+}
+
+void EsalSaiApis::populate(void) {
+    int numApis = 0;
+    for (int api = SAI_API_UNSPECIFIED + 1; api < SAI_API_MAX; api++) {
+        void *table = nullptr;
+        if (!sai_api_query((sai_api_t) api, &table) && table) {
+            tables_[api] = table;
+            numApis++;
+        } else {
+            tables_[api] = nullptr;
+        }
+    }
+    valid_.store(true, std::memory_order_release);
+    std::cout << "EsalSaiApis cached: " << numApis << "\n" << std::flush;
+}
+
+void EsalSaiApis::invalidate(void) {
+    valid_.store(false, std::memory_order_release);
+}
+
+sai_status_t EsalSaiApis::query(sai_api_t api, void **table) {
+    if (valid_.load(std::memory_order_acquire) &&
+        (api > SAI_API_UNSPECIFIED) && (api < SAI_API_MAX) && tables_[api]) {
+        *table = tables_[api];
+        return SAI_STATUS_SUCCESS;
+    }
+    return sai_api_query(api, table);
+}
+
+sai_status_t esalSaiApiQuery(sai_api_t api, void **table) {
+    return EsalSaiApis::instance().query(api, table);
+}
+
+bool esalSaiApiBenchmark(uint32_t numVlans, std::string &report) {
+    // Tables a VLAN is provisioned with: create, add members, their bridge
+    // ports, and the port default VLAN.
+    const sai_api_t perVlan[] = { SAI_API_VLAN, SAI_API_VLAN,
+                                  SAI_API_BRIDGE, SAI_API_PORT };
+    const uint32_t numPerVlan = sizeof(perVlan) / sizeof(perVlan[0]);
+    uint32_t numCalls = numVlans * numPerVlan;
+    void *table = nullptr;
+    uint32_t fails[2] = {0, 0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numCalls; i++) {
+        if (sai_api_query(perVlan[i % numPerVlan], &table)) fails[0]++;
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < numCalls; i++) {
+        if (esalSaiApiQuery(perVlan[i % numPerVlan], &table)) fails[1]++;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t nsecs[2];
+    nsecs[0] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   mid - start).count();
+    nsecs[1] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   end - mid).count();
+    std::stringstream ss;
+    ss << "esalSaiApiBenchmark vlans=" << numVlans << " calls=" << numCalls
+       << " nsecPerCall sai_api_query="
+       << (numCalls ? nsecs[0] / numCalls : 0)
+       << " cached=" << (numCalls ? nsecs[1] / numCalls : 0)
+       << " savedUsec="
+       << ((nsecs[0] > nsecs[1]) ? (nsecs[0] - nsecs[1]) / 1000 : 0)
+       << " fails=" << fails[0] << "/" << fails[1] << std::endl;
+    report = ss.str();
+    return !fails[1];
+}
+#endif
+
 sai_object_id_t esalSwitchId = SAI_NULL_OBJECT_ID;
 int esalInitSwitch(std::vector<sai_attribute_t>& attributes, sai_switch_api_t *saiSwitchApi) {
 #ifndef UTS
@@ -675,6 +821,9 @@ int esalInitSwitch(std::vector<sai_attribute_t>& attributes, sai_switch_api_t *s
         }
     }
 
+    // Ports and the sai.cfg port map are in place, so cache them for Rx.
+    esalHostPortMapRefresh();
+
     // Create default STP group
     if (!esalStpCreate(&defStpId)) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
@@ -874,14 +1023,18 @@ int DllInit(void) {
 
 #ifndef UTS
 
-    // Initialize the SAI.
+    // Initialize the SAI, and cache its method tables.
     //
     sai_api_initialize(0, &testServices);
+    EsalSaiApis::instance().populate();
+    std::string apiReport;
+    esalSaiApiBenchmark(4094, apiReport);
+    std::cout << apiReport << std::flush;
 
     // Query to get switch_api
     //  
     sai_switch_api_t *saiSwitchApi; 
-    sai_status_t retcode = sai_api_query(SAI_API_SWITCH, (void**)&saiSwitchApi);
+    sai_status_t retcode = esalSaiApiQuery(SAI_API_SWITCH, (void**)&saiSwitchApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "API Query Fail in DllInit\n"));
@@ -1013,6 +1166,115 @@ int DllInit(void) {
                   << esalHealthMonitorCycle << "\n" << std::flush;
     }
 #endif
+
+    if (esalProfileMap.count("fdbResyncChunk")) {
+        std::string resyncChunk = esalProfileMap["fdbResyncChunk"];
+        esalFdbResyncChunk = std::stoi(resyncChunk.c_str());
+        std::cout << "FDB Resync Chunk: " 
+                  << esalFdbResyncChunk << "\n" << std::flush;
+    }
+
+    // MAC move storm limits, moves per second per MAC and per port.
+    //
+    uint32_t fdbMoveMacThreshold = 0;
+    uint32_t fdbMovePortThreshold = 0;
+    uint32_t fdbMoveStormHoldSec = 30;
+    bool fdbMoveStormDisableLearning = false;
+    if (esalProfileMap.count("fdbMoveMacThreshold")) {
+        std::string threshold = esalProfileMap["fdbMoveMacThreshold"];
+        fdbMoveMacThreshold = std::stoi(threshold.c_str());
+    }
+    if (esalProfileMap.count("fdbMovePortThreshold")) {
+        std::string threshold = esalProfileMap["fdbMovePortThreshold"];
+        fdbMovePortThreshold = std::stoi(threshold.c_str());
+    }
+    if (esalProfileMap.count("fdbMoveStormHoldSec")) {
+        std::string holdSec = esalProfileMap["fdbMoveStormHoldSec"];
+        fdbMoveStormHoldSec = std::stoi(holdSec.c_str());
+    }
+    if (esalProfileMap.count("fdbMoveStormDisableLearning")) {
+        std::string disableLearning = esalProfileMap["fdbMoveStormDisableLearning"];
+        fdbMoveStormDisableLearning =
+            (disableLearning == "Y") || (disableLearning == "y");
+    }
+    esalFdbMoveStormConfig(fdbMoveMacThreshold, fdbMovePortThreshold,
+                           fdbMoveStormHoldSec, fdbMoveStormDisableLearning);
+
+    // Start the FDB event worker before the switch can raise notifications.
+    //
+    uint32_t fdbEventRingDepth = 0;
+    if (esalProfileMap.count("fdbEventRingDepth")) {
+        std::string ringDepth = esalProfileMap["fdbEventRingDepth"];
+        fdbEventRingDepth = std::stoi(ringDepth.c_str());
+    }
+    if (!esalFdbEventRingStart(fdbEventRingDepth)) {
+        std::cout << "esalFdbEventRingStart fail, FDB events applied inline\n";
+    }
+
+    // Link events go through the link worker, which reports a port only
+    // once its state has held for linkDebounceMsec.
+    //
+    uint32_t linkDebounceMsec = 0;
+    if (esalProfileMap.count("linkDebounceMsec")) {
+        std::string debounce = esalProfileMap["linkDebounceMsec"];
+        linkDebounceMsec = std::stoi(debounce.c_str());
+    }
+    if (!esalLinkEventStart(linkDebounceMsec)) {
+        std::cout << "esalLinkEventStart fail, link events applied inline\n";
+    }
+
+    // Flush bounds for batched Rx delivery, see VendorRegisterRxBatchCb.
+    //
+    uint32_t rxBatchMaxPkts = 0;
+    uint32_t rxBatchMaxUsec = 1000;
+    if (esalProfileMap.count("rxBatchMaxPkts")) {
+        std::string maxPkts = esalProfileMap["rxBatchMaxPkts"];
+        rxBatchMaxPkts = std::stoi(maxPkts.c_str());
+    }
+    if (esalProfileMap.count("rxBatchMaxUsec")) {
+        std::string maxUsec = esalProfileMap["rxBatchMaxUsec"];
+        rxBatchMaxUsec = std::stoi(maxUsec.c_str());
+    }
+    esalHostRxBatchConfig(rxBatchMaxPkts, rxBatchMaxUsec);
+
+    // Rx worker pool, per filter queues drained by priority.  Zero keeps
+    // delivery on the SAI packet thread.
+    //
+    uint32_t rxWorkerThreads = 0;
+    uint32_t rxQueueDepth = 0;
+    if (esalProfileMap.count("rxWorkerThreads")) {
+        std::string workers = esalProfileMap["rxWorkerThreads"];
+        rxWorkerThreads = std::stoi(workers.c_str());
+    }
+    if (esalProfileMap.count("rxQueueDepth")) {
+        std::string queueDepth = esalProfileMap["rxQueueDepth"];
+        rxQueueDepth = std::stoi(queueDepth.c_str());
+    }
+    esalHostRxPoolConfig(rxWorkerThreads, rxQueueDepth);
+    if (!esalHostRxPoolStart()) {
+        std::cout << "esalHostRxPoolStart fail, Rx delivered inline\n";
+    }
+
+    // Trap to CPU policing, packets per second per ingress port, and per
+    // filter as a list of filterName:pps.
+    //
+    if (esalProfileMap.count("rxPortPolicerPps")) {
+        std::string portPps = esalProfileMap["rxPortPolicerPps"];
+        esalHostRxPortPolicerConfig(std::stoi(portPps.c_str()));
+    }
+    if (esalProfileMap.count("rxFilterPolicer")) {
+        std::stringstream filterRates(esalProfileMap["rxFilterPolicer"]);
+        std::string filterRate;
+        while (filterRates >> filterRate) {
+            size_t pos = filterRate.rfind(":");
+            if ((pos == std::string::npos) || !pos) {
+                std::cout << "rxFilterPolicer error: bad entry " << filterRate << "\n";
+                continue;
+            }
+            esalHostRxFilterPolicerConfig(filterRate.substr(0, pos),
+                std::stoi(filterRate.substr(pos + 1).c_str()));
+        }
+    }
 #endif
 
     // The point we need to jump to to re-initialize (make a hard reset) if "hot boot restore" fails.
@@ -1047,6 +1309,28 @@ int DllInit(void) {
 #endif
     }
 
+    // Size the shadow FDB to match what the device can hold.  Any events
+    // raised since the switch came up are waiting in the FDB event ring.
+    //
+    uint32_t fdbCapacity = 0;
+#ifdef HAVE_MRVL
+    GT_U32 fdbTblSize = 0;
+    GT_STATUS fdbRc = cpssDxChCfgTableNumEntriesGet(
+                        0, CPSS_DXCH_CFG_TABLE_FDB_E, &fdbTblSize);
+    if (fdbRc == GT_OK) {
+        fdbCapacity = fdbTblSize;
+    } else {
+        std::cout << "cpssDxChCfgTableNumEntriesGet fail: " << fdbRc
+                  << ", using default FDB shadow size\n";
+    }
+#endif
+    if (!esalFdbTableInit(fdbCapacity)) {
+        SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
+              SWERR_FILELINE, "esalFdbTableInit Fail in DllInit\n"));
+        std::cout << "esalFdbTableInit failed\n";
+        return ESAL_RC_FAIL;
+    }
+
 #ifndef UTS
     // Remove the backup folder.
     //
@@ -1072,10 +1356,27 @@ int DllDestroy(void) {
     }
 #ifndef UTS
 
+    // Settle outstanding link events while SAI is still up; any later
+    // notification is applied inline.
+    //
+    esalLinkEventStop();
+
+    // Drain and stop the FDB worker while SAI is still up, its final
+    // drain may toggle learning.  Later notifications are applied inline.
+    //
+    esalFdbEventRingStop();
+
+    // Likewise deliver any queued or staged Rx packets to the application
+    // before SAI goes away.  The pool goes first, as its final drain may
+    // stage into a batch.
+    //
+    esalHostRxPoolStop();
+    esalHostRxBatchStop();
+
     // Query to get switch_api
     //  
     sai_switch_api_t *saiSwitchApi; 
-    sai_status_t retcode = sai_api_query(SAI_API_SWITCH, (void**)&saiSwitchApi);
+    sai_status_t retcode = esalSaiApiQuery(SAI_API_SWITCH, (void**)&saiSwitchApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
               SWERR_FILELINE, "sai_api_query Fail in DllDestroy\n"));
@@ -1105,10 +1406,10 @@ int DllDestroy(void) {
         std::cout << "remove switch fail: " << esalSaiError(retcode) << "\n"; 
         return ESAL_RC_FAIL;
     }
+    EsalSaiApis::instance().invalidate();
     sai_api_uninitialize();
     esalSwitchId = SAI_NULL_OBJECT_ID;
 
-
 #endif 
 
     // Unload the SFP Library.
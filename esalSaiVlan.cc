@@ -89,7 +89,7 @@ int VendorCreateVlan(uint16_t vlanid) {
 #ifndef UTS
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode =  sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode =  esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorCreateVlan\n"));
@@ -157,7 +157,7 @@ int VendorDeleteVlan(uint16_t vlanid) {
 #ifndef UTS
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode = sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode = esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorDeleteVlan\n"));
@@ -210,7 +210,7 @@ int VendorAddPortsToVlan(uint16_t vlanid, uint16_t numPorts, const uint16_t port
     //
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode = sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode = esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
             SWERR_FILELINE, "sai_api_query fail in VendorAddPortsToVlan\n"));
@@ -333,7 +333,7 @@ int VendorDeletePortsFromVlan(uint16_t vlanid, uint16_t numPorts, const uint16_t
 #ifndef UTS
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode = sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode = esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail in VendorDeletePortsFromVlan\n"));
@@ -463,7 +463,7 @@ int VendorSetPortDefaultVlan(uint16_t lPort, uint16_t vlanid) {
 #ifndef UTS
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode = sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode = esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail in VendorSetPortDefaultVlan\n"));
@@ -532,7 +532,7 @@ int VendorGetPortDefaultVlan(uint16_t lPort, uint16_t *vlanid) {
 #ifndef UTS
     sai_status_t retcode;
     sai_port_api_t *saiPortApi;
-    retcode = sai_api_query(SAI_API_PORT, (void**) &saiPortApi);
+    retcode = esalSaiApiQuery(SAI_API_PORT, (void**) &saiPortApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query in VendorGetPortDefaultVlan\n"));
@@ -608,7 +608,7 @@ int VendorTagPacketsOnIngress(uint16_t lPort) {
 #ifndef UTS
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode =  sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode =  esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail in VendorTagPacketsOnIngress\n"));
@@ -745,7 +745,7 @@ int esalVlanAddPortTagPushPop(uint16_t pPort, bool ingr, bool push) {
 #ifndef UTS
     sai_status_t retcode;
     sai_vlan_api_t *saiVlanApi;
-    retcode =  sai_api_query(SAI_API_VLAN, (void**) &saiVlanApi);
+    retcode =  esalSaiApiQuery(SAI_API_VLAN, (void**) &saiVlanApi);
     if (retcode) {
         SWERR(Swerr(Swerr::SwerrLevel::KS_SWERR_ONLY,
                     SWERR_FILELINE, "sai_api_query fail in VendorSetPortNniMode\n"));
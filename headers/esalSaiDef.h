@@ -18,6 +18,7 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <algorithm>
 #include <sys/stat.h>
 #include "esalSaiUtils.h"
@@ -41,6 +42,29 @@ extern "C" {
 }
 #endif
 
+#ifndef UTS
+// Process wide SAI method tables.  DllInit fills them once, right after
+// sai_api_initialize, and DllDestroy drops them before
+// sai_api_uninitialize.  Modules get their tables through esalSaiApiQuery,
+// which only goes to sai_api_query outside that window or for a table SAI
+// did not have at start up.
+class EsalSaiApis {
+ public:
+    static EsalSaiApis &instance(void);
+    void populate(void);
+    void invalidate(void);
+    sai_status_t query(sai_api_t api, void **table);
+
+ private:
+    EsalSaiApis();
+    void *tables_[SAI_API_MAX];
+    std::atomic<bool> valid_;
+};
+
+extern "C" sai_status_t esalSaiApiQuery(sai_api_t api, void **table);
+extern "C" bool esalSaiApiBenchmark(uint32_t numVlans, std::string &report);
+#endif
+
 #ifdef LARCH_ENVIRON
 #define SWERR(x)
 #else
@@ -79,6 +103,7 @@ extern bool esalFindBridgePortSaiFromPortSai(
                 sai_object_id_t portSai, sai_object_id_t *bridgePortSai);
 extern bool esalFindBridgePortSaiFromPortId(
                 uint16_t portId, sai_object_id_t *bridgePortSai);
+extern int esalBridgeSetMacLearning(uint16_t portId, bool enabled);
 extern bool esalPortTableSet(
                 uint16_t tableIndex, sai_object_id_t portSai, uint16_t portId);
 extern void esalPortSetStp(uint16_t portId, vendor_stp_state_t stpState);
@@ -89,6 +114,73 @@ extern bool esalBridgePortRemove(sai_object_id_t portSai, uint16_t vlanId);
 extern bool esalBridgePortListInit(uint32_t port_number);
 extern void esalAlterForwardingTable(
                 sai_fdb_event_notification_data_t *fdbNotify);
+extern bool esalFdbBenchmark(uint32_t numEvents, std::string &report);
+extern bool esalFilterMatchBenchmark(uint32_t numPackets, std::string &report);
+extern void esalHostPortMapRefresh(void);
+extern void esalHostRxBatchConfig(uint32_t maxPkts, uint32_t maxUsec);
+extern void esalHostRxBatchStop(void);
+extern bool esalHostRxBatchStats(uint64_t *enqueued, uint64_t *overflows,
+                                 uint64_t *batches);
+extern void esalHostRxPoolConfig(uint32_t workers, uint32_t queueDepth);
+extern bool esalHostRxPoolStart(void);
+extern void esalHostRxPoolStop(void);
+extern bool esalHostRxQueueStats(std::string &report);
+extern void esalHostRxPortPolicerConfig(uint32_t pps);
+extern void esalHostRxFilterPolicerConfig(const std::string &filterName,
+                                          uint32_t pps);
+extern bool esalHostRxPolicerStats(std::string &report);
+extern bool esalTxBenchmark(uint16_t lPort, uint32_t numPkts,
+                            std::string &report);
+extern bool esalHostCaptureStart(uint32_t slots, uint32_t snapLen,
+                                 const std::string &path);
+extern void esalHostCaptureStop(void);
+extern bool esalHostCaptureFilter(const std::string &spec);
+extern bool esalHostCaptureStats(std::string &report);
+
+// Rx classification counters and the latency of esalHandleSaiHostRxPacket.
+// portMisses is by lPort, with misses on unresolved ports last.  latency
+// holds the non empty histogram buckets as {largest nsec, count}.
+struct EsalRxFilterStats {
+    std::string filterName;
+    uint64_t hits;
+    uint64_t bytes;
+};
+
+struct EsalRxStatsSnapshot {
+    std::vector<EsalRxFilterStats> filters;
+    std::vector<uint64_t> portMisses;
+    std::vector<std::pair<uint64_t, uint64_t>> latency;
+    uint64_t latencyCount;
+    uint64_t latencyP50Nsec;
+    uint64_t latencyP99Nsec;
+    uint64_t latencyP999Nsec;
+    uint64_t latencyMaxNsec;
+};
+
+extern bool esalHostRxStatsSnapshot(EsalRxStatsSnapshot &snap);
+extern bool esalHostRxStats(std::string &report);
+extern void esalHostRxStatsClear(void);
+extern bool esalFdbTableInit(uint32_t capacity);
+extern bool esalFdbTableStats(uint32_t *size, uint32_t *capacity,
+                              uint32_t *highWater, uint64_t *dropped,
+                              bool *alarm);
+extern void esalFdbMoveStormConfig(uint32_t macThreshold,
+                uint32_t portThreshold, uint32_t holdSec, bool disableLearning);
+extern bool esalFdbMoveStormStats(uint64_t *moves, uint64_t *suppressedMac,
+                uint64_t *suppressedPort, uint32_t *portsInStorm);
+extern bool esalFdbEventRingStart(uint32_t depth);
+extern void esalFdbEventRingStop(void);
+extern void esalEnqueueFdbEvents(
+                uint32_t count, sai_fdb_event_notification_data_t *fdbNotify);
+extern void esalEnqueueFdbResyncEvents(
+                uint32_t count, sai_fdb_event_notification_data_t *fdbNotify);
+extern bool esalFdbEventRingStats(uint64_t *enqueued, uint64_t *overflows,
+                                  uint32_t *depth, uint32_t *highWater);
+extern bool esalLinkEventStart(uint32_t debounceMsec);
+extern void esalLinkEventStop(void);
+extern void esalEnqueueLinkEvents(uint32_t count,
+                const sai_port_oper_status_notification_t *ntif);
+extern void esalLinkEventDump(bool clear, std::string &report);
 
 extern int16_t esalHostPortId;
 extern char esalHostIfName[];
@@ -134,6 +226,93 @@ typedef struct
     bool valid;
 } macData;
 
+// Shadow FDB change journal, see VendorGetMacTblDelta.  The lPort is not
+// meaningful for a vlan or full flush, nor the vlanId for a port flush.
+enum VendorMacDeltaOp {
+    MAC_DELTA_LEARN = 0,
+    MAC_DELTA_AGE,
+    MAC_DELTA_MOVE,
+    MAC_DELTA_FLUSH_PORT,
+    MAC_DELTA_FLUSH_VLAN,
+    MAC_DELTA_FLUSH_ALL
+};
+
+typedef struct
+{
+    uint64_t gen;
+    uint8_t op;
+    unsigned char mac[6];
+    uint16_t lPort;
+    uint16_t vlanId;
+} VendorMacDelta;
+
+// Returns up to *numRecs changes after sinceGen and sets *curGen to the
+// generation to poll from next.  When *resync is set the journal no longer
+// covers sinceGen; re-read with VendorGetMacTbl and continue from *curGen.
+int VendorGetMacTblDelta(uint64_t sinceGen, uint16_t *numRecs,
+                         VendorMacDelta *recs, uint64_t *curGen, bool *resync);
+
+// Port a MAC was learned on, answered from the shadow FDB without going to
+// SAI.  The bulk form takes numMacs 6-byte MACs back to back and sets the
+// lPort of any MAC not found to ESAL_MAC_NOT_FOUND.
+const uint16_t ESAL_MAC_NOT_FOUND = 0xFFFF;
+int VendorFindMac(const unsigned char *mac, uint16_t vlanId, uint16_t *lPort);
+int VendorFindMacBulk(uint16_t numMacs, const unsigned char *macs,
+                      const uint16_t *vlanIds, uint16_t *lPorts,
+                      uint16_t *numFound);
+
+// Batched form of the Rx callback.  Packets are only valid for the
+// duration of the call.  Once registered, it replaces the single packet
+// callback.  Rx callbacks are never made concurrently, even with several
+// Rx worker threads.
+typedef struct
+{
+    const char *filterName;
+    uint16_t lPort;
+    uint16_t length;
+    void *packet;
+} VendorRxPacket;
+
+typedef void (*VendorRxBatchCallback_fp_t)(void *cbId, uint32_t numPkts,
+                                           VendorRxPacket *pkts);
+int VendorRegisterRxBatchCb(VendorRxBatchCallback_fp_t cb, void *cbId);
+
+// Sends numPkts packets, each out its own lPort, and sets *numSent to the
+// number accepted.  Fails if any packet could not be sent.
+typedef struct
+{
+    uint16_t lPort;
+    uint16_t length;
+    const void *packet;
+} VendorTxPacket;
+
+int VendorSendPackets(uint16_t numPkts, const VendorTxPacket *pkts,
+                      uint16_t *numSent);
+
+// Oper status, speed, autoneg, duplex and FEC of a port, read with one
+// get_port_attribute.  speed is a vendor_speed_t, duplex a vendor_duplex_t
+// and fec a sai_port_fec_mode_t.  The all ports form fills up to *numPorts
+// entries, one per provisioned port, and sets *numPorts to the count.
+typedef struct __attribute__((packed))
+{
+    uint16_t lPort;
+    bool linkUp;
+    bool autoneg;
+    uint8_t speed;
+    uint8_t duplex;
+    uint8_t fec;
+} VendorPortStatus;
+
+int VendorGetPortStatus(uint16_t lPort, VendorPortStatus *status);
+int VendorGetAllPortStatus(uint16_t *numPorts, VendorPortStatus *status);
+
+// Port status as cached from port notifications, re-read from hardware
+// when stale or when forceRefresh is set.  VendorGetPortLinkState,
+// VendorGetPortRate and VendorGetPortDuplex are served from this cache.
+int VendorGetPortCachedStatus(uint16_t lPort, bool forceRefresh,
+                              VendorPortStatus *status);
+void esalPortStateDump(int32_t lPort, bool forceRefresh, std::string &report);
+
 struct aclTableAttributes {
     uint8_t field_out_port;
     uint8_t field_dst_ipv6;
@@ -32,6 +32,16 @@
   ESALSAI_DIP_CLASS(DipEsalPolicerStats); 
   ESALSAI_DIP_CLASS(DipEsalClearPolicerStats);
   ESALSAI_DIP_CLASS(DipEsalDumpSfp);
+  ESALSAI_DIP_CLASS(DipEsalFdbBenchmark);
+  ESALSAI_DIP_CLASS(DipEsalFdbStats);
+  ESALSAI_DIP_CLASS(DipEsalFilterBenchmark);
+  ESALSAI_DIP_CLASS(DipEsalRxQueueStats);
+  ESALSAI_DIP_CLASS(DipEsalRxPolicerStats);
+  ESALSAI_DIP_CLASS(DipEsalTxBenchmark);
+  ESALSAI_DIP_CLASS(DipEsalCapture);
+  ESALSAI_DIP_CLASS(DipEsalRxStats);
+  ESALSAI_DIP_CLASS(DipEsalPortState);
+  ESALSAI_DIP_CLASS(DipEsalLinkEvents);
 
 class EsalSaiDips {
  public:
@@ -48,12 +58,54 @@ class EsalSaiDips {
                         esalsai_dip_, nullptr),
         esalDumpSfp_("esalsai/esalDumpSfp",
                         "esalDumpSfp lPort",
+                        esalsai_dip_, nullptr),
+        esalFdbBenchmark_("esalsai/esalFdbBenchmark",
+                        "esalFdbBenchmark [numEvents]",
+                        esalsai_dip_, nullptr),
+        esalFdbStats_("esalsai/esalFdbStats",
+                        "esalFdbStats",
+                        esalsai_dip_, nullptr),
+        esalFilterBenchmark_("esalsai/esalFilterBenchmark",
+                        "esalFilterBenchmark [numPackets]",
+                        esalsai_dip_, nullptr),
+        esalRxQueueStats_("esalsai/esalRxQueueStats",
+                        "esalRxQueueStats",
+                        esalsai_dip_, nullptr),
+        esalRxPolicerStats_("esalsai/esalRxPolicerStats",
+                        "esalRxPolicerStats [filterName pps]",
+                        esalsai_dip_, nullptr),
+        esalTxBenchmark_("esalsai/esalTxBenchmark",
+                        "esalTxBenchmark lPort [numPkts]",
+                        esalsai_dip_, nullptr),
+        esalCapture_("esalsai/esalCapture",
+                        "esalCapture on [slots] [snapLen] [path] | off | "
+                        "filter [rx|tx] [port=N] [filter=name] "
+                        "[offset:data[:mask]]... | status",
+                        esalsai_dip_, nullptr),
+        esalRxStats_("esalsai/esalRxStats",
+                        "esalRxStats [clear]",
+                        esalsai_dip_, nullptr),
+        esalPortState_("esalsai/esalPortState",
+                        "esalPortState [lPort|all] [refresh]",
+                        esalsai_dip_, nullptr),
+        esalLinkEvents_("esalsai/esalLinkEvents",
+                        "esalLinkEvents [clear]",
                         esalsai_dip_, nullptr)
 {
   esalsai_dip_->dip_register_command(&esalHealthMon_);
   esalsai_dip_->dip_register_command(&esalPolicerStats_);
   esalsai_dip_->dip_register_command(&esalClearPolicerStats_);
   esalsai_dip_->dip_register_command(&esalDumpSfp_);
+  esalsai_dip_->dip_register_command(&esalFdbBenchmark_);
+  esalsai_dip_->dip_register_command(&esalFdbStats_);
+  esalsai_dip_->dip_register_command(&esalFilterBenchmark_);
+  esalsai_dip_->dip_register_command(&esalRxQueueStats_);
+  esalsai_dip_->dip_register_command(&esalRxPolicerStats_);
+  esalsai_dip_->dip_register_command(&esalTxBenchmark_);
+  esalsai_dip_->dip_register_command(&esalCapture_);
+  esalsai_dip_->dip_register_command(&esalRxStats_);
+  esalsai_dip_->dip_register_command(&esalPortState_);
+  esalsai_dip_->dip_register_command(&esalLinkEvents_);
 }
 protected:
   std::shared_ptr<DipCommand> esalsai_dip_;
@@ -63,6 +115,16 @@ protected:
   EsalSaiDipEsalPolicerStats        esalPolicerStats_;
   EsalSaiDipEsalClearPolicerStats   esalClearPolicerStats_;
   EsalSaiDipEsalDumpSfp             esalDumpSfp_;
+  EsalSaiDipEsalFdbBenchmark        esalFdbBenchmark_;
+  EsalSaiDipEsalFdbStats            esalFdbStats_;
+  EsalSaiDipEsalFilterBenchmark     esalFilterBenchmark_;
+  EsalSaiDipEsalRxQueueStats        esalRxQueueStats_;
+  EsalSaiDipEsalRxPolicerStats      esalRxPolicerStats_;
+  EsalSaiDipEsalTxBenchmark         esalTxBenchmark_;
+  EsalSaiDipEsalCapture             esalCapture_;
+  EsalSaiDipEsalRxStats             esalRxStats_;
+  EsalSaiDipEsalPortState           esalPortState_;
+  EsalSaiDipEsalLinkEvents          esalLinkEvents_;
 };
 #endif
 #endif //ESAL_VENDOR_API_HEADERS_ESALSAIDIP_H